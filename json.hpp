@@ -3,11 +3,12 @@
 #define JSON_H_INCLUDE_HEADER_
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <array>
 #include <map>
-#include <iterator> //random_access_iterator_tag
 #include <functional>
+#include <iterator> //random_access_iterator_tag
 #include <algorithm>
 #include <type_traits>
 #include <variant>
@@ -16,12 +17,37 @@
 #include <iomanip>
 #include <exception>
 #include <numeric>
+#include <limits>
+#include <utility>
 
 #include <cassert>
 #include <cstdlib>
 #include <cmath>
 #include <cstdio>
 #include <cstdint> //int64_t
+#include <cstring> //memcpy
+#include <charconv> //from_chars
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define JSON_HAS_PMR
+#endif
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)//C++20 async_parse
+#include <coroutine>
+#include <optional>
+#define JSON_HAS_COROUTINES
+#if __has_include(<unistd.h>)//fd_source
+#include <unistd.h>
+#include <cerrno>
+#include <system_error>
+#define JSON_HAS_POSIX_FD
+#endif
+#endif
 
 //you can define custom assert or parse error macros and override it
 
@@ -41,8 +67,17 @@
 #endif//NDEBUG
 #endif//JSON_ASSERT
 
+#ifndef JSON_DEFAULT_MAX_DEPTH//default nesting limit for arrays/objects
+#define JSON_DEFAULT_MAX_DEPTH 512
+#endif
+
+#ifndef JSON_PARALLEL_PRINT_MIN_VALUES//to_string_parallel starts one thread per this many values
+#define JSON_PARALLEL_PRINT_MIN_VALUES 4096
+#endif
+
 namespace CompactJSON {
-    class JSONBase;
+    template <typename Traits> class BasicJSON;
+    class TapeValue;
     namespace details {
         inline void json_assert_impl(bool passed, int line, const std::string& file, bool fatal = true) {
             if (!passed) {
@@ -52,8 +87,156 @@ namespace CompactJSON {
                     throw std::runtime_error("assertion failed");
             }
         }
+    } //namespace details
+
+    enum class json_errc : uint8_t {
+        none = 0,
+        unexpected_end,         //input ended inside value, string or comment
+        unexpected_character,
+        invalid_literal,        //misspelled true, false or null
+        invalid_number,
+        number_out_of_range,    //float overflows double
+        invalid_string_char,    //unescaped control character inside string
+        invalid_escape,         //unknown escape sequence or unpaired surrogate
+        invalid_utf8,
+        comments_disabled,
+        depth_exceeded,
+        trailing_characters     //non-space characters after root value
+    };
+    [[nodiscard]] inline const char* error_description(json_errc e) noexcept {
+        switch (e) {
+        case json_errc::none: return "json: no error";
+        case json_errc::unexpected_end: return "json: unexpected end of file";
+        case json_errc::unexpected_character: return "json: unexpected character";
+        case json_errc::invalid_literal: return "json: invalid literal";
+        case json_errc::invalid_number: return "json: invalid number";
+        case json_errc::number_out_of_range: return "json: number too large";
+        case json_errc::invalid_string_char: return "json: control character in string";
+        case json_errc::invalid_escape: return "json: invalid escape sequence";
+        case json_errc::invalid_utf8: return "json: invalid utf8";
+        case json_errc::comments_disabled: return "json: comments is not enabled";
+        case json_errc::depth_exceeded: return "json: max nesting depth exceeded";
+        case json_errc::trailing_characters: return "json: unexpected character after value";
+        default: break;
+        }
+        return "json: unknown error";
+    }
+    struct validate_result {
+        json_errc error = json_errc::none;
+        size_t offset = 0;//byte offset of the error
+        explicit operator bool() const noexcept { return error == json_errc::none; }
+    };
+
+    struct parse_options {
+        bool enable_comments = false;
+        size_t max_depth = JSON_DEFAULT_MAX_DEPTH;//nesting limit for arrays and objects
+        bool lazy_numbers = false;//keep number text, convert it on get<T>() (exact uint64_t and big integers)
+    };
+    //approximate heap usage of document in bytes (allocator overhead is not included)
+    struct memory_usage_info {
+        size_t nodes = 0;//JSON nodes (root included)
+        size_t strings = 0;//string values, keys and raw numbers which don't fit into small string buffer
+        size_t arrays = 0;//array buffers (capacity)
+        size_t objects = 0;//map nodes without keys
+        [[nodiscard]] size_t total() const noexcept { return nodes + strings + arrays + objects; }
+    };
+    //keys kept by try_parse, other values are skipped without decoding. arrays are transparent
+    //("items.id" keeps "id" of every object in "items" array, scalars on the way to "id" are skipped).
+    //empty projection keeps only root container.
+    //instead of paths predicate can decide for each key (key and depth of object)
+    class projection {
+    public:
+        static constexpr size_t npos = size_t(-1);
+        projection() = default;
+        projection(std::initializer_list<std::string_view> paths, char separator = '.') {
+            for (auto path : paths) add(path, separator);
+        }
+        explicit projection(std::function<bool(std::string_view key, size_t depth)> keep) : m_keep(std::move(keep)) {}
+
+        projection& add(std::string_view path, char separator = '.') {
+            size_t n = 0;
+            for (;;) {
+                if (m_nodes[n].keep_all) return *this;//prefix of path is already kept
+                size_t pos = path.find(separator);
+                std::string_view key = path.substr(0, pos);
+                auto f = m_nodes[n].children.find(key);
+                if (f == m_nodes[n].children.end()) {//grow m_nodes first, it moves maps of all nodes
+                    size_t child = m_nodes.size();
+                    m_nodes.emplace_back();
+                    m_nodes[n].children.emplace(std::string(key), child);
+                    n = child;
+                }
+                else n = f->second;
+                if (pos == std::string_view::npos) break;
+                path.remove_prefix(pos + 1);
+            }
+            m_nodes[n].keep_all = true;
+            m_nodes[n].children.clear();
+            return *this;
+        }
+        //state of value inside object with state `state` under key, or npos if it is skipped. root state is 0
+        [[nodiscard]] size_t child(size_t state, std::string_view key) const {
+            if (m_keep) return m_keep(key, state) ? state + 1 : npos;
+            const auto& n = m_nodes[state];
+            if (n.keep_all) return state;
+            auto f = n.children.find(key);
+            return f == n.children.end() ? npos : f->second;
+        }
+        //scalars are kept only by selected paths, inside intermediate objects and arrays they are skipped
+        [[nodiscard]] bool keeps_scalars(size_t state) const noexcept { return m_keep || m_nodes[state].keep_all; }
+    private:
+        struct node {
+            std::map<std::string, size_t, std::less<>> children;
+            bool keep_all = false;
+        };
+        std::vector<node> m_nodes = std::vector<node>(1);
+        std::function<bool(std::string_view, size_t)> m_keep;
+    };
+
+    struct parse_error {
+        json_errc code = json_errc::none;
+        size_t offset = 0;//byte offset
+        size_t line = 1, column = 1;//1-based, column counted in bytes
+        [[nodiscard]] const char* what() const noexcept { return error_description(code); }
+        [[nodiscard]] std::string message() const {
+            return std::string(what()) + " (line " + std::to_string(line) + ", column " + std::to_string(column) + ")";
+        }
+    };
+    //holds parsed value or parse_error (like std::expected<T, parse_error>)
+    template <typename T>
+    class parse_result {
+    public:
+        parse_result(T&& v) : m_value(std::in_place_index<0>, std::move(v)) {}
+        parse_result(const parse_error& e) : m_value(std::in_place_index<1>, e) {}
+        [[nodiscard]] bool has_value() const noexcept { return m_value.index() == 0; }
+        explicit operator bool() const noexcept { return has_value(); }
+        [[nodiscard]] T& value() & { JSON_ASSERT(has_value()); return *std::get_if<0>(&m_value); }
+        [[nodiscard]] const T& value() const & { JSON_ASSERT(has_value()); return *std::get_if<0>(&m_value); }
+        [[nodiscard]] T&& value() && { JSON_ASSERT(has_value()); return std::move(*std::get_if<0>(&m_value)); }
+        [[nodiscard]] const parse_error& error() const { JSON_ASSERT(!has_value()); return *std::get_if<1>(&m_value); }
+        T& operator*() & { return value(); }
+        const T& operator*() const & { return value(); }
+        T&& operator*() && { return std::move(*this).value(); }
+        T* operator->() { return &value(); }
+        const T* operator->() const { return &value(); }
+    private:
+        std::variant<T, parse_error> m_value;
+    };
+
+    namespace details {
+        inline json_errc skip_utf8_char(const char*& p, const char* end) noexcept;
+        inline void append_hex4(std::string& s, uint32_t v) {//"\uXXXX"
+            s += '\\';
+            s += 'u';
+            for (int shift = 12; shift >= 0; shift -= 4) {
+                uint32_t d = (v >> shift) & 0xF;
+                s += char(d < 10 ? '0' + d : 'A' + d - 10);
+            }
+        }
         //TODO move here scan_string (rename to string from escape ...?)
-        inline std::string escape_sec_to_string(const std::string& str) {//str is unicode (utf8) string
+        //output is ascii: other characters are written as \uXXXX (surrogate pairs above U+FFFF).
+        //bytes which are not valid utf-8 are written as \u00XX
+        inline std::string escape_sec_to_string(std::string_view str) {//str is unicode (utf8) string
             std::string ret;
             for (size_t i = 0; i < str.size(); i++) {
                 unsigned char ch = static_cast<unsigned char>(str[i]);
@@ -66,103 +249,894 @@ namespace CompactJSON {
                 case '\"': ret += '\\'; ret += '"'; break;
                 case '\\': ret += '\\'; ret += '\\'; break;
                 default: {
-                    if (std::isprint(ch) && ch < 128) ret += ch;//printable ascii character
-                    else {//non printable or unicode. convert to Unicode
-                        ret += '\\'; ret += 'u';// "\u"
-                        uint32_t char_code = 0;
-                        if (ch < 0b11000000) char_code = ch;//1 wide
-                        else if (ch < 0b11100000 && i + 1 < str.size())//2 wide
-                            char_code = ((uint32_t(static_cast<unsigned char>(ch)) & 0b00011111) << 6) | ((uint32_t(static_cast<unsigned char>(str[i + 1])) & 0b00111111));
-                        else if (ch < 0b11110000 && i + 2 < str.size())//3 wide
-                            char_code = ((((uint32_t(static_cast<unsigned char>(ch)) & 0b00001111) << 6) | (uint32_t(static_cast<unsigned char>(str[i + 1])) & 0b00111111)) << 6)
-                            | (uint32_t(static_cast<unsigned char>(str[i + 2])) & 0b00111111);
-                        else if (i + 3 < str.size()) {//4 wide
-                            char_code = ((((((uint32_t(static_cast<unsigned char>(ch)) & 0b00000111) << 6) | (uint32_t(static_cast<unsigned char>(str[i + 1])) & 0b00111111)) << 6)
-                                          | (uint32_t(static_cast<unsigned char>(str[i + 2])) & 0b00111111)) << 6) | uint32_t(static_cast<unsigned char>(str[i + 3])) & 0b00111111;
-                        }
-                        if(char_code > (1 << 16)) {
-                            JSON_ASSERT(0);
-                        }
-                        char buf[4];
-                        for (size_t i = 0; i < 4; i++) {
-                            int v = char_code % 16;
-                            buf[3 - i] = v < 10 ? '0' + v : 'A' + v - 10;
-                            char_code /= 16;
-                        }
-                        JSON_ASSERT(char_code == 0);//converted successful
-                        for (size_t i = 0; i < 4; i++) ret += buf[i];
+                    if (std::isprint(ch) && ch < 128) {//printable ascii character
+                        ret += char(ch);
+                        break;
+                    }
+                    const char* p = str.data() + i;
+                    if (ch < 0x80 || skip_utf8_char(p, str.data() + str.size()) != json_errc::none) {
+                        append_hex4(ret, ch);//control character or invalid byte
+                        break;
+                    }
+                    size_t n = size_t(p - (str.data() + i));//2..4 bytes
+                    uint32_t cp = ch & (0xFF >> (n + 1));
+                    for (size_t k = 1; k < n; k++)
+                        cp = (cp << 6) | (static_cast<unsigned char>(str[i + k]) & 0b00111111);
+                    if (cp < 0x10000) append_hex4(ret, cp);
+                    else {
+                        cp -= 0x10000;
+                        append_hex4(ret, 0xD800 + (cp >> 10));
+                        append_hex4(ret, 0xDC00 + (cp & 0x3FF));
                     }
+                    i += n - 1;
                 } break;
                 }
             }
             return ret;
         }
 
-        //TODO move scan string here?
-        inline std::variant<int64_t, double> scan_number(int& ch, std::istream& in) {
-            bool is_positive = ch != '-', has_float = false, has_exp = false;
-            if ((ch == '+' || ch == '-') && in.good()) ch = in.get();
-            std::string int_part, fract_part;
-            int exp_part = 0;
-            if (std::isdigit(ch)) {
-                int_part += ch;
-                while (in.good() && std::isdigit(ch = in.get())) int_part += ch;
-            }
-            if (ch == '.') {
-                has_float = true; //fractional part
-                while (in.good() && std::isdigit(ch = in.get())) fract_part += ch;
-                if(fract_part.size() > 308) fract_part.resize(308);
-            }
-            if (ch == 'e' || ch == 'E') {
-                has_exp = true;
-                bool is_exp_positive = true;
-                ch = in.get(); //exponent (all numbers with exp is float)
-                if (ch == '-') is_exp_positive = false;
-                size_t exp_size = 0;
-                if (std::isdigit(ch)) exp_part += ch - '0', exp_size = 1;
-                int prev_exp = 0;
-                while (in.good() && std::isdigit(ch = in.get())) {
-                    prev_exp = exp_part;
-                    exp_part = exp_part * 10 + ch - '0';//TODO overflow check
-                    exp_size++;
-                    if(prev_exp > exp_part) JSON_PARSE_ERROR("json: number exponent overflow");
-                }
-
-                if(exp_size == 0) JSON_PARSE_ERROR("json: number invalid exponent");
-                if(!is_exp_positive) exp_part = -exp_part;
-                if(exp_part > 308) JSON_PARSE_ERROR("json: number too large exponent");//TODO return +inf?
-                if(exp_part < -308) return 0.;
-            } //now number is: (is_positive ? 1 : -1) * (int_part + fract_part/fract_div) * 10^((is_exp_positive ? 1 : -1) * exp_part)
-
-            static std::array<double, 308*2+1> pow10_table = ([](){
-                static std::array<double, 308*2+1> ret;
-                for(size_t i = 0; i <= 308*2; i++) ret[i] = std::pow(10, int(i)-308);
-                return ret;
-            })();
-
-            if(has_exp || has_float) {
-                double iv = int_part.size() ? std::stod(int_part) : 0.;
-                double fv = fract_part.size() ? std::stod(fract_part) * pow10_table[308 - fract_part.size()] : 0.;
-                return std::copysign((iv + fv) * pow10_table[308 + exp_part], is_positive ? 1. : -1.);
-            }
-
-            if(int_part.size() == 0) JSON_PARSE_ERROR("json: invalid number");
-            
-            bool has_overflow = int_part.size() > 19;
-
-            int64_t int_val = 0, prev_val = 0;
-            if(!has_overflow) for(auto ch : int_part) {
-                prev_val = int_val;
-                int_val *= 10, int_val += ch - '0';
-                if(prev_val > int_val) {
-                    has_overflow = true;  
+        //buffer scanning primitives. all of them take [p, end) range, advance p and never allocate
+        inline bool is_space(char ch) noexcept { return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t'; }
+        inline json_errc skip_spaces_and_comments(const char*& p, const char* end, bool enable_comments) noexcept {
+            while (p != end) {
+                if (is_space(*p)) ++p;
+                else if (*p == '/') {
+                    if (!enable_comments) return json_errc::comments_disabled;
+                    if (end - p < 2) return json_errc::unexpected_end;
+                    if (p[1] == '/') {
+                        p += 2;
+                        while (p != end && *p != '\n') ++p;
+                    }
+                    else if (p[1] == '*') {
+                        const char* c = p + 2;
+                        while (c + 1 < end && !(c[0] == '*' && c[1] == '/')) ++c;
+                        if (c + 1 >= end) return json_errc::unexpected_end;
+                        p = c + 2;
+                    }
+                    else return json_errc::unexpected_character;
+                }
+                else break;
+            }
+            return json_errc::none;
+        }
+        inline int hex_digit(char ch) noexcept {
+            if ('0' <= ch && ch <= '9') return ch - '0';
+            if ('a' <= ch && ch <= 'f') return ch - 'a' + 10;
+            if ('A' <= ch && ch <= 'F') return ch - 'A' + 10;
+            return -1;
+        }
+        inline json_errc scan_hex4(const char*& p, const char* end, uint32_t& v) noexcept {
+            if (end - p < 4) return json_errc::unexpected_end;
+            v = 0;
+            for (size_t i = 0; i < 4; i++) {
+                int d = hex_digit(p[i]);
+                if (d < 0) return json_errc::invalid_escape;
+                v = v * 16 + uint32_t(d);
+            }
+            p += 4;
+            return json_errc::none;
+        }
+        //p points after "\u". surrogate pairs are combined, unpaired surrogates rejected
+        inline json_errc scan_unicode_escape(const char*& p, const char* end, uint32_t& codepoint) noexcept {
+            if (auto e = scan_hex4(p, end, codepoint); e != json_errc::none) return e;
+            if (0xDC00 <= codepoint && codepoint <= 0xDFFF) return json_errc::invalid_escape;
+            if (0xD800 <= codepoint && codepoint <= 0xDBFF) {
+                if (p == end) return json_errc::unexpected_end;
+                if (p[0] != '\\') return json_errc::invalid_escape;//unpaired high surrogate
+                if (p + 1 == end) return json_errc::unexpected_end;
+                if (p[1] != 'u') return json_errc::invalid_escape;
+                p += 2;
+                uint32_t low;
+                if (auto e = scan_hex4(p, end, low); e != json_errc::none) return e;
+                if (!(0xDC00 <= low && low <= 0xDFFF)) return json_errc::invalid_escape;
+                codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+            }
+            return json_errc::none;
+        }
+        //p points to non-ascii lead byte. checks well-formed utf-8 (no overlongs, surrogates or codepoints above U+10FFFF)
+        inline json_errc skip_utf8_char(const char*& p, const char* end) noexcept {
+            auto c = static_cast<unsigned char>(*p);
+            ptrdiff_t n = 0;
+            unsigned char lo = 0x80, hi = 0xBF;
+            if (0xC2 <= c && c <= 0xDF) n = 1;
+            else if (0xE0 <= c && c <= 0xEF) {
+                n = 2;
+                if (c == 0xE0) lo = 0xA0;
+                else if (c == 0xED) hi = 0x9F;
+            }
+            else if (0xF0 <= c && c <= 0xF4) {
+                n = 3;
+                if (c == 0xF0) lo = 0x90;
+                else if (c == 0xF4) hi = 0x8F;
+            }
+            else return json_errc::invalid_utf8;
+            if (end - p <= n) return json_errc::unexpected_end;
+            auto c1 = static_cast<unsigned char>(p[1]);
+            if (c1 < lo || c1 > hi) return json_errc::invalid_utf8;
+            for (ptrdiff_t i = 2; i <= n; i++)
+                if ((static_cast<unsigned char>(p[i]) & 0b11000000) != 0b10000000) return json_errc::invalid_utf8;
+            p += n + 1;
+            return json_errc::none;
+        }
+        //p points to opening '"'. on success p points after closing '"'
+        inline json_errc skip_string(const char*& p, const char* end) noexcept {
+            ++p;
+            while (p != end) {
+                auto c = static_cast<unsigned char>(*p);
+                if (c == '"') {
+                    ++p;
+                    return json_errc::none;
+                }
+                if (c == '\\') {
+                    if (++p == end) break;
+                    switch (*p++) {
+                    case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't': break;
+                    case 'u': {
+                        uint32_t cp;
+                        if (auto e = scan_unicode_escape(p, end, cp); e != json_errc::none) return e;
+                        break;
+                    }
+                    default: --p; return json_errc::invalid_escape;
+                    }
+                }
+                else if (c < 0x20) return json_errc::invalid_string_char;
+                else if (c < 0x80) ++p;
+                else if (auto e = skip_utf8_char(p, end); e != json_errc::none) return e;
+            }
+            return json_errc::unexpected_end;
+        }
+        //-?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+        inline json_errc skip_number(const char*& p, const char* end, bool& is_integer) noexcept {
+            auto is_digit = [](char ch) { return '0' <= ch && ch <= '9'; };
+            is_integer = true;
+            if (p != end && *p == '-') ++p;
+            if (p == end) return json_errc::unexpected_end;
+            if (*p == '0') ++p;
+            else if (is_digit(*p)) while (p != end && is_digit(*p)) ++p;
+            else return json_errc::invalid_number;
+            if (p != end && *p == '.') {
+                is_integer = false;
+                if (++p == end) return json_errc::unexpected_end;
+                if (!is_digit(*p)) return json_errc::invalid_number;
+                while (p != end && is_digit(*p)) ++p;
+            }
+            if (p != end && (*p == 'e' || *p == 'E')) {
+                is_integer = false;
+                if (++p != end && (*p == '+' || *p == '-')) ++p;
+                if (p == end) return json_errc::unexpected_end;
+                if (!is_digit(*p)) return json_errc::invalid_number;
+                while (p != end && is_digit(*p)) ++p;
+            }
+            return json_errc::none;
+        }
+        //true if valid number text is too large for double (try_parse fails on it, underflow gives 0). doesn't allocate:
+        //decimal exponent decides, std::from_chars is used only for values in [1e308, 1e309)
+        inline bool number_overflows(std::string_view text) noexcept {
+            auto is_digit = [](char ch) { return '0' <= ch && ch <= '9'; };
+            const char* p = text.data(), * const end = p + text.size();
+            if (*p == '-') ++p;
+            const char* q = p;
+            while (q != end && is_digit(*q)) ++q;
+            int64_t magnitude = q - p;//value is below 10^magnitude
+            if (*p == '0') {//no leading zeros in json, so it is 0 or 0.xxx
+                if (q == end || *q != '.') return false;
+                const char* first = ++q;
+                while (q != end && *q == '0') ++q;
+                if (q == end || !is_digit(*q)) return false;//zero
+                magnitude = first - q;
+            }
+            while (q != end && *q != 'e' && *q != 'E') ++q;
+            if (q != end) {
+                bool negative = *++q == '-';
+                if (*q == '-' || *q == '+') ++q;
+                int64_t exp = 0;
+                for (; q != end; ++q)
+                    if (exp < 100000) exp = exp * 10 + (*q - '0');//saturated, far beyond double range
+                magnitude += negative ? -exp : exp;
+            }
+            if (magnitude != 309) return magnitude > 309;
+            double d;
+            return std::from_chars(text.data(), end, d).ec == std::errc::result_out_of_range;
+        }
+        inline json_errc skip_literal(const char*& p, const char* end, std::string_view lit) noexcept {
+            size_t n = std::min(lit.size(), size_t(end - p));
+            if (std::string_view(p, n) != lit.substr(0, n)) return json_errc::invalid_literal;
+            if (n < lit.size()) return json_errc::unexpected_end;
+            p += n;
+            return json_errc::none;
+        }
+
+        //stack of container kinds (true for object). first 4096 levels are stored inline, deeper ones on heap
+        class bit_stack {
+        public:
+            [[nodiscard]] size_t size() const noexcept { return m_size; }
+            [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+            [[nodiscard]] bool top() const noexcept { return (word(m_size - 1) >> ((m_size - 1) % 64)) & 1; }
+            bool push(bool v) noexcept {//false if memory can't be allocated
+                if (m_size / 64 >= inline_words + m_heap.size()) {
+                    try { m_heap.push_back(0); }
+                    catch (...) { return false; }
+                }
+                uint64_t& w = word(m_size);
+                uint64_t bit = uint64_t(1) << (m_size % 64);
+                w = v ? w | bit : w & ~bit;
+                ++m_size;
+                return true;
+            }
+            void pop() noexcept { --m_size; }
+            void clear() noexcept { m_size = 0; }
+        private:
+            static constexpr size_t inline_words = 64;
+            uint64_t& word(size_t i) noexcept { return i / 64 < inline_words ? m_inline[i / 64] : m_heap[i / 64 - inline_words]; }
+            const uint64_t& word(size_t i) const noexcept { return i / 64 < inline_words ? m_inline[i / 64] : m_heap[i / 64 - inline_words]; }
+            uint64_t m_inline[inline_words];
+            std::vector<uint64_t> m_heap;
+            size_t m_size = 0;
+        };
+
+        //grammar check of one value (with nested values) without building it. allocates only for nesting deeper than 4096.
+        //check_range also rejects numbers which overflow double (as conversion in try_parse does)
+        inline json_errc skip_value(const char*& p, const char* end, bool enable_comments, size_t max_depth, bool check_range = false) noexcept {
+            bit_stack stack;
+            auto in_object = [&]() { return stack.top(); };
+            json_errc e;
+            auto scan_key = [&]() -> json_errc {//"key" :
+                if (p == end) return json_errc::unexpected_end;
+                if (*p != '"') return json_errc::unexpected_character;
+                if ((e = skip_string(p, end)) != json_errc::none) return e;
+                if ((e = skip_spaces_and_comments(p, end, enable_comments)) != json_errc::none) return e;
+                if (p == end) return json_errc::unexpected_end;
+                if (*p != ':') return json_errc::unexpected_character;
+                ++p;
+                return json_errc::none;
+            };
+            for (;;) {//value expected
+                if ((e = skip_spaces_and_comments(p, end, enable_comments)) != json_errc::none) return e;
+                if (p == end) return json_errc::unexpected_end;
+                switch (*p) {
+                case '[': case '{': {
+                    bool is_object = *p == '{';
+                    if (stack.size() >= max_depth || !stack.push(is_object)) return json_errc::depth_exceeded;
+                    ++p;
+                    if ((e = skip_spaces_and_comments(p, end, enable_comments)) != json_errc::none) return e;
+                    if (p != end && *p == (is_object ? '}' : ']')) {//empty container
+                        ++p;
+                        stack.pop();
+                        break;
+                    }
+                    if (is_object && (e = scan_key()) != json_errc::none) return e;
+                    continue;
+                }
+                case '"': e = skip_string(p, end); break;
+                case '-': case '0': case '1': case '2': case '3': case '4':
+                case '5': case '6': case '7': case '8': case '9': {
+                    bool is_integer;
+                    const char* number = p;
+                    e = skip_number(p, end, is_integer);
+                    if (e == json_errc::none && check_range && number_overflows(std::string_view(number, size_t(p - number)))) {
+                        p = number;//reported at number start, as by try_parse
+                        e = json_errc::number_out_of_range;
+                    }
+                    break;
+                }
+                case 't': e = skip_literal(p, end, "true"); break;
+                case 'f': e = skip_literal(p, end, "false"); break;
+                case 'n': e = skip_literal(p, end, "null"); break;
+                default: e = json_errc::unexpected_character; break;
+                }
+                if (e != json_errc::none) return e;
+                for (;;) {//after value: ',' or closing brackets
+                    if (stack.empty()) return json_errc::none;
+                    if ((e = skip_spaces_and_comments(p, end, enable_comments)) != json_errc::none) return e;
+                    if (p == end) return json_errc::unexpected_end;
+                    if (*p == (in_object() ? '}' : ']')) {
+                        ++p;
+                        stack.pop();
+                        continue;
+                    }
+                    if (*p != ',') return json_errc::unexpected_character;
+                    ++p;
+                    if (in_object()) {
+                        if ((e = skip_spaces_and_comments(p, end, enable_comments)) != json_errc::none) return e;
+                        if ((e = scan_key()) != json_errc::none) return e;
+                    }
                     break;
                 }
             }
+        }
+        inline validate_result validate(std::string_view str, bool enable_comments, size_t max_depth) noexcept {
+            const char* p = str.data(), * const end = str.data() + str.size();
+            json_errc e = skip_value(p, end, enable_comments, max_depth, true);
+            if (e == json_errc::none) e = skip_spaces_and_comments(p, end, enable_comments);
+            if (e == json_errc::none && p != end) e = json_errc::trailing_characters;
+            return e == json_errc::none ? validate_result{} : validate_result{ e, size_t(p - str.data()) };
+        }
+        inline parse_error make_parse_error(std::string_view str, json_errc code, size_t offset) noexcept {
+            parse_error e{ code, offset };
+            for (size_t i = 0; i < offset && i < str.size(); i++) {
+                if (str[i] == '\n') e.line++, e.column = 1;
+                else e.column++;
+            }
+            return e;
+        }
+        inline void append_utf8(std::string& s, uint32_t cp) {
+            if (cp < 0x80) s += char(cp);
+            else if (cp < 0x800) {
+                s += char(0b11000000 | (cp >> 6));
+                s += char(0b10000000 | (cp & 0b00111111));
+            }
+            else if (cp < 0x10000) {
+                s += char(0b11100000 | (cp >> 12));
+                s += char(0b10000000 | ((cp >> 6) & 0b00111111));
+                s += char(0b10000000 | (cp & 0b00111111));
+            }
+            else {
+                s += char(0b11110000 | (cp >> 18));
+                s += char(0b10000000 | ((cp >> 12) & 0b00111111));
+                s += char(0b10000000 | ((cp >> 6) & 0b00111111));
+                s += char(0b10000000 | (cp & 0b00111111));
+            }
+        }
+
+        inline json_errc parse_double(std::string_view text, double& d) {
+            auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), d);
+            if (ec == std::errc::result_out_of_range) {//overflow or underflow, strtod tells which one
+                d = std::strtod(std::string(text).c_str(), nullptr);
+                if (std::isinf(d)) return json_errc::number_out_of_range;
+            }
+            else if (ec != std::errc() || ptr != text.data() + text.size()) return json_errc::invalid_number;
+            return json_errc::none;
+        }
+
+        //iterative parser over contiguous buffer. containers are tracked in explicit stack (limited by parse_options::max_depth)
+        //and values are reported to Handler (sax-like interface, every callback returns json_errc):
+        //  null_value(), boolean(bool), number(string_view text, bool is_integer), string(string_view),
+        //  key(string_view), start_array(), end_array(), start_object(), end_object()
+        //  skip_value(bool is_container) - called before each value, if it returns true value is only validated
+        //string_view arguments are valid only during the call. nothing throws except allocation
+        template <typename Handler>
+        class parser {
+        public:
+            parser(std::string_view str, const parse_options& opts) noexcept
+                : m_begin(str.data()), m_p(str.data()), m_end(str.data() + str.size()), m_token(str.data()), m_opts(opts) {}
+
+            json_errc parse(Handler& h) {
+                m_stack.clear();
+                m_state = state::value;
+                m_partial = partial::none;
+                m_skipping = false;
+                return resume(h, true);
+            }
+            //input split into chunks: set next part with input() and call resume(h, last). if resume stops at the end
+            //of not last chunk, incomplete() is true and offset() points to start of unfinished token. next input must
+            //start with that token: checked part of unfinished string, number, comment or skipped value is not scanned again
+            void input(std::string_view str) noexcept {
+                m_begin = m_p = m_token = str.data();
+                m_end = str.data() + str.size();
+            }
+            json_errc resume(Handler& h, bool last) {
+                m_incomplete = false;
+                for (;;) {
+                    json_errc e = step(h, last);
+                    if (e == json_errc::none) {
+                        if (m_skipping && m_state == state::after && m_stack.size() == m_skip_base) m_skipping = false;//skipped value ended
+                        if (m_state == state::done) return json_errc::none;
+                        continue;
+                    }
+                    if (e == json_errc::unexpected_end && !last) {//wait for next chunk
+                        m_p = m_token;
+                        m_incomplete = true;
+                    }
+                    return e;
+                }
+            }
+            [[nodiscard]] bool incomplete() const noexcept { return m_incomplete; }
+            [[nodiscard]] bool complete() const noexcept { return m_stack.empty() && (m_state == state::after || m_state == state::done); }//root value parsed
+            [[nodiscard]] size_t offset() const noexcept { return size_t(m_p - m_begin); }
+        private:
+            enum class state : uint8_t {
+                value,//value expected
+                first,//after '[' or '{', value, key or closing bracket expected
+                key,//"key" expected
+                colon,//':' after key expected
+                after,//after value: ',' or closing brackets
+                done
+            };
+            enum class partial : uint8_t { none, string, number, comment };//token cut by end of chunk
+            json_errc step(Handler& h, bool last) {//one token
+                json_errc e;
+                if (m_partial == partial::none || m_partial == partial::comment) {
+                    if ((e = skip_spaces(last)) != json_errc::none) return e;
+                    m_token = m_p;
+                }
+                switch (m_state) {
+                case state::value: {
+                    if (m_p == m_end) return json_errc::unexpected_end;
+                    const char* token = m_token;
+                    if (m_partial == partial::none && !m_skipping && h.skip_value(*m_p == '[' || *m_p == '{')) {
+                        e = skip_value(m_p, m_end, m_opts.enable_comments, m_opts.max_depth - m_stack.size());
+                        bool cut = e == json_errc::unexpected_end || (e == json_errc::none && m_p == m_end);//skipped number can continue
+                        if (!cut || last) {
+                            if (e == json_errc::none) m_state = state::after;
+                            return e;
+                        }
+                        m_p = token;//value is skipped token by token, so only unfinished token is kept between chunks
+                        m_skipping = true;
+                        m_skip_base = m_stack.size();
+                    }
+                    switch (*m_p) {
+                    case '[': case '{': {
+                        bool is_object = *m_p == '{';
+                        if (m_stack.size() >= m_opts.max_depth) return json_errc::depth_exceeded;
+                        if (!m_skipping && (e = is_object ? h.start_object() : h.start_array()) != json_errc::none) return e;
+                        m_stack.push_back(is_object);
+                        ++m_p;
+                        m_state = state::first;
+                        return json_errc::none;
+                    }
+                    case '"': {
+                        std::string_view s;
+                        if ((e = parse_string(s)) == json_errc::none && !m_skipping) e = h.string(s);
+                        break;
+                    }
+                    case '-': case '0': case '1': case '2': case '3': case '4':
+                    case '5': case '6': case '7': case '8': case '9': {
+                        if (!last) {//number can continue in next chunk
+                            const char* p = m_partial == partial::number ? m_token + m_scanned : m_p;
+                            while (p != m_end && is_number_char(*p)) ++p;
+                            if (p == m_end) {
+                                m_partial = partial::number;
+                                m_scanned = size_t(p - m_token);
+                                return json_errc::unexpected_end;
+                            }
+                        }
+                        m_partial = partial::none;
+                        bool is_integer;
+                        if ((e = skip_number(m_p, m_end, is_integer)) != json_errc::none || m_skipping) break;
+                        if ((e = h.number(std::string_view(token, size_t(m_p - token)), is_integer)) != json_errc::none)
+                            m_p = token;//conversion error is reported at number start
+                        break;
+                    }
+                    case 't': if ((e = skip_literal(m_p, m_end, "true")) == json_errc::none && !m_skipping) e = h.boolean(true); break;
+                    case 'f': if ((e = skip_literal(m_p, m_end, "false")) == json_errc::none && !m_skipping) e = h.boolean(false); break;
+                    case 'n': if ((e = skip_literal(m_p, m_end, "null")) == json_errc::none && !m_skipping) e = h.null_value(); break;
+                    default: e = json_errc::unexpected_character; break;
+                    }
+                    if (e == json_errc::none) m_state = state::after;
+                    return e;
+                }
+                case state::first: {
+                    if (m_p == m_end) return json_errc::unexpected_end;
+                    bool is_object = m_stack.back();
+                    if (*m_p == (is_object ? '}' : ']')) {//empty container
+                        ++m_p;
+                        m_stack.pop_back();
+                        m_state = state::after;
+                        return m_skipping ? json_errc::none : is_object ? h.end_object() : h.end_array();
+                    }
+                    m_state = is_object ? state::key : state::value;
+                    return json_errc::none;
+                }
+                case state::key: {
+                    if (m_p == m_end) return json_errc::unexpected_end;
+                    if (*m_p != '"') return json_errc::unexpected_character;
+                    std::string_view key;
+                    if ((e = parse_string(key)) != json_errc::none) return e;
+                    if (!m_skipping && (e = h.key(key)) != json_errc::none) return e;
+                    m_state = state::colon;
+                    return json_errc::none;
+                }
+                case state::colon:
+                    if (m_p == m_end) return json_errc::unexpected_end;
+                    if (*m_p != ':') return json_errc::unexpected_character;
+                    ++m_p;
+                    m_state = state::value;
+                    return json_errc::none;
+                case state::after: {
+                    if (m_stack.empty()) {
+                        if (m_p != m_end) return json_errc::trailing_characters;
+                        if (!last) return json_errc::unexpected_end;//only spaces can follow
+                        m_state = state::done;
+                        return json_errc::none;
+                    }
+                    if (m_p == m_end) return json_errc::unexpected_end;
+                    bool is_object = m_stack.back();
+                    if (*m_p == (is_object ? '}' : ']')) {
+                        ++m_p;
+                        m_stack.pop_back();
+                        return m_skipping ? json_errc::none : is_object ? h.end_object() : h.end_array();
+                    }
+                    if (*m_p != ',') return json_errc::unexpected_character;
+                    ++m_p;
+                    m_state = is_object ? state::key : state::value;
+                    return json_errc::none;
+                }
+                case state::done: default: return json_errc::none;
+                }
+            }
+            static bool is_number_char(char ch) noexcept { return ('0' <= ch && ch <= '9') || ch == '-' || ch == '+' || ch == '.' || ch == 'e' || ch == 'E'; }
+            json_errc skip_spaces(bool last) noexcept {
+                for (;;) {
+                    if (m_partial != partial::comment) {
+                        while (m_p != m_end && is_space(*m_p)) ++m_p;
+                        if (m_p == m_end || *m_p != '/') return json_errc::none;
+                        if (!m_opts.enable_comments) return json_errc::comments_disabled;
+                        m_token = m_p;
+                        m_scanned = 0;
+                    }
+                    if (json_errc e = skip_comment(last); e != json_errc::none) return e;
+                }
+            }
+            //m_token points to '/', first m_scanned bytes of comment are checked
+            json_errc skip_comment(bool last) noexcept {
+                m_partial = partial::comment;
+                if (m_end - m_token < 2) return json_errc::unexpected_end;
+                const char* p = m_token + std::max<size_t>(m_scanned, 2);
+                if (m_token[1] == '/') {
+                    while (p != m_end && *p != '\n') ++p;
+                    if (p == m_end && !last) {
+                        m_scanned = size_t(p - m_token);
+                        return json_errc::unexpected_end;
+                    }
+                }
+                else if (m_token[1] == '*') {
+                    while (p + 1 < m_end && !(p[0] == '*' && p[1] == '/')) ++p;
+                    if (p + 1 >= m_end) {
+                        m_scanned = size_t(p - m_token);
+                        return json_errc::unexpected_end;
+                    }
+                    p += 2;
+                }
+                else return json_errc::unexpected_character;
+                m_partial = partial::none;
+                m_p = p;
+                return json_errc::none;
+            }
+            //m_token points to opening '"'. strings without escapes are returned as view into input, others are decoded into m_buf.
+            //if string is cut by end of input, checked part is remembered in m_scanned/m_run/m_has_escapes
+            json_errc parse_string(std::string_view& out) {
+                const char* run;
+                bool has_escapes;
+                if (m_partial == partial::string) {
+                    m_p = m_token + m_scanned;
+                    run = m_token + m_run;
+                    has_escapes = m_has_escapes;
+                }
+                else {
+                    run = m_p = m_token + 1;
+                    has_escapes = false;
+                }
+                m_partial = partial::none;
+                auto cut = [&](const char* resume_at) {
+                    m_partial = partial::string;
+                    m_scanned = size_t(resume_at - m_token);
+                    m_run = size_t(run - m_token);
+                    m_has_escapes = has_escapes;
+                    return json_errc::unexpected_end;
+                };
+                while (m_p != m_end) {
+                    auto c = static_cast<unsigned char>(*m_p);
+                    if (c == '"') {
+                        if (has_escapes) m_buf.append(run, m_p), out = m_buf;
+                        else out = std::string_view(run, size_t(m_p - run));
+                        ++m_p;
+                        return json_errc::none;
+                    }
+                    if (c == '\\') {
+                        if (!has_escapes) m_buf.clear(), has_escapes = true;
+                        m_buf.append(run, m_p);
+                        const char* escape = run = m_p;
+                        if (++m_p == m_end) return cut(escape);
+                        switch (*m_p++) {
+                        case '"': m_buf += '"'; break;
+                        case '\\': m_buf += '\\'; break;
+                        case '/': m_buf += '/'; break;
+                        case 'b': m_buf += '\b'; break;
+                        case 'f': m_buf += '\f'; break;
+                        case 'n': m_buf += '\n'; break;
+                        case 'r': m_buf += '\r'; break;
+                        case 't': m_buf += '\t'; break;
+                        case 'u': {
+                            uint32_t cp;
+                            if (json_errc e = scan_unicode_escape(m_p, m_end, cp); e != json_errc::none)
+                                return e == json_errc::unexpected_end ? cut(escape) : e;
+                            append_utf8(m_buf, cp);
+                            break;
+                        }
+                        default: --m_p; return json_errc::invalid_escape;
+                        }
+                        run = m_p;
+                    }
+                    else if (c < 0x20) return json_errc::invalid_string_char;
+                    else if (c < 0x80) ++m_p;
+                    else {
+                        const char* ch = m_p;
+                        if (json_errc e = skip_utf8_char(m_p, m_end); e != json_errc::none)
+                            return e == json_errc::unexpected_end ? cut(ch) : e;
+                    }
+                }
+                return cut(m_p);
+            }
+
+            const char* m_begin, * m_p, * m_end;
+            const char* m_token;//start of current token, input is kept from here when chunk ends inside token
+            parse_options m_opts;
+            std::vector<bool> m_stack;//true for object
+            std::string m_buf;//decoded string with escapes
+            state m_state = state::value;
+            partial m_partial = partial::none;
+            size_t m_scanned = 0;//checked bytes of partial token
+            size_t m_run = 0;//partial string: offset of text which is not copied to m_buf yet
+            bool m_has_escapes = false;//partial string: m_buf holds decoded text
+            bool m_skipping = false;//value rejected by Handler::skip_value is parsed without callbacks
+            size_t m_skip_base = 0;//stack size at start of skipped value
+            bool m_incomplete = false;
+        };
+
+        //parser handler which builds JSON_ tree. nodes are allocated with root allocator
+        template <typename JSON_>
+        class dom_builder {
+            using val_t = typename JSON_::val_t;
+        public:
+            explicit dom_builder(JSON_& root, bool lazy_numbers = false, const projection* proj = nullptr) noexcept
+                : m_root(root), m_lazy_numbers(lazy_numbers), m_proj(proj) {}
+            bool skip_value(bool is_container) {
+                if (std::exchange(m_skip, false)) return true;
+                if (!m_proj || is_container || m_stack.empty()) return false;
+                JSON_& top = *m_stack.back();
+                if (top.is_array()) return !m_proj->keeps_scalars(m_states.back());
+                if (m_proj->keeps_scalars(m_pending_state)) return false;
+                top.destroy_node(m_pending_key->second);//scalar at intermediate path node
+                top.obj.erase(m_pending_key);
+                return true;
+            }
+            json_errc null_value() { next().clear(); return json_errc::none; }
+            json_errc boolean(bool b) {
+                auto& v = next();
+                v.set_type_to(val_t::bool_t);
+                v.b = b;
+                return json_errc::none;
+            }
+            json_errc number(std::string_view text, bool is_integer) {
+                auto& v = next();
+                if (m_lazy_numbers) {
+                    v.set_type_to(val_t::raw_number_t);
+                    v.raw.text.assign(text.data(), text.size());
+                    return json_errc::none;
+                }
+                return v.set_number(text, is_integer);
+            }
+            json_errc string(std::string_view s) {
+                auto& v = next();
+                v.set_type_to(val_t::string_t);
+                v.str.assign(s.data(), s.size());
+                return json_errc::none;
+            }
+            json_errc key(std::string_view k) {
+                if (m_proj && (m_pending_state = m_proj->child(m_states.back(), k)) == projection::npos) {
+                    m_skip = true;
+                    return json_errc::none;
+                }
+                JSON_& top = *m_stack.back();
+                auto f = top.obj.lower_bound(k);
+                if (f != top.obj.end() && f->first == k) f->second->clear();//duplicate key, last one wins
+                else f = top.emplace_node(f, k, top.create_node());
+                m_pending = f->second;
+                m_pending_key = f;
+                return json_errc::none;
+            }
+            json_errc start_array() { return start(val_t::array_t); }
+            json_errc start_object() { return start(val_t::object_t); }
+            json_errc end_array() { return end(); }
+            json_errc end_object() { return end(); }
+        private:
+            JSON_& next() {//value slot in current container
+                if (m_stack.empty()) return m_root;
+                JSON_* top = m_stack.back();
+                if (top->is_array()) {
+                    top->push_node(top->create_node());
+                    return *top->arr.back();
+                }
+                return *m_pending;
+            }
+            json_errc start(val_t t) {
+                if (m_proj)//elements of array have same projection state as array
+                    m_states.push_back(m_stack.empty() ? 0 : m_stack.back()->is_array() ? m_states.back() : m_pending_state);
+                auto& v = next();
+                v.set_type_to(t);
+                m_stack.push_back(&v);
+                return json_errc::none;
+            }
+            json_errc end() {
+                m_stack.pop_back();
+                if (m_proj) m_states.pop_back();
+                return json_errc::none;
+            }
+
+            JSON_& m_root;
+            bool m_lazy_numbers;
+            JSON_* m_pending = nullptr;//value for last key
+            typename JSON_::object_type::iterator m_pending_key{};
+            std::vector<JSON_*> m_stack;
+            const projection* m_proj;
+            std::vector<size_t> m_states;//projection state of each container in m_stack
+            size_t m_pending_state = 0;
+            bool m_skip = false;
+        };
+
+        inline void print_double(std::ostream& ostr, double d) {
+            if (!std::isfinite(d)) {
+                ostr << "null";
+                return;
+            }
+            char buf[32];//shortest representation which is parsed back to same double
+            auto res = std::to_chars(buf, buf + sizeof(buf), d);
+            ostr.write(buf, res.ptr - buf);
+        }
 
-            if(has_overflow) return std::copysign(std::stod(int_part), is_positive ? 1. : -1.);
-            return (is_positive ? int_val : -int_val);
+        //TapeDocument layout. each value starts with word (tag << 56 | payload):
+        //  null, true, false - one word
+        //  int64, uint64, double - tag word and raw 64 bit value
+        //  string (and key) - payload is offset in string buffer, next word is length
+        //  [ { - payload is index of closing word, next word is index of element table (0 if container has none)
+        //  ] } - payload is number of elements (distinct keys for objects)
+        //object elements are key followed by value, in document order. key which is repeated later in same
+        //object is tagged hidden_key (same layout as string), so lookups and iteration see only last one.
+        //containers with more than tape_index_min elements get element table, stored after root value:
+        //indices of array elements in order, or indices of visible keys of object sorted by key
+        enum class tape_tag : uint8_t {
+            null_value = 'n', true_value = 't', false_value = 'f',
+            int64 = 'l', uint64 = 'u', double_value = 'd', string = 's', hidden_key = 'h',
+            start_array = '[', end_array = ']', start_object = '{', end_object = '}'
+        };
+        constexpr uint64_t tape_payload_mask = (uint64_t(1) << 56) - 1;
+        constexpr size_t tape_index_min = 16;//smaller containers are scanned
+        [[nodiscard]] constexpr uint64_t tape_word(tape_tag t, uint64_t payload = 0) noexcept { return uint64_t(t) << 56 | (payload & tape_payload_mask); }
+        [[nodiscard]] constexpr tape_tag tape_tag_of(uint64_t w) noexcept { return tape_tag(w >> 56); }
+        [[nodiscard]] constexpr uint64_t tape_payload(uint64_t w) noexcept { return w & tape_payload_mask; }
+        [[nodiscard]] inline size_t tape_next(const uint64_t* tape, size_t i) noexcept {//index of value after value at i
+            switch (tape_tag_of(tape[i])) {
+            case tape_tag::start_array: case tape_tag::start_object: return size_t(tape_payload(tape[i])) + 1;
+            case tape_tag::int64: case tape_tag::uint64: case tape_tag::double_value: case tape_tag::string: case tape_tag::hidden_key: return i + 2;
+            default: return i + 1;
+            }
         }
+
+        //parser handler which writes TapeDocument words
+        class tape_builder {
+        public:
+            tape_builder(std::vector<uint64_t>& tape, std::string& strings) noexcept : m_tape(tape), m_strings(strings) {}
+            bool skip_value(bool) noexcept { return false; }
+            json_errc null_value() { value(); m_tape.push_back(tape_word(tape_tag::null_value)); return json_errc::none; }
+            json_errc boolean(bool b) {
+                value();
+                m_tape.push_back(tape_word(b ? tape_tag::true_value : tape_tag::false_value));
+                return json_errc::none;
+            }
+            json_errc number(std::string_view text, bool is_integer) {
+                value();
+                if (is_integer) {
+                    int64_t i;
+                    if (std::from_chars(text.data(), text.data() + text.size(), i).ec == std::errc())
+                        return push(tape_tag::int64, static_cast<uint64_t>(i));
+                    uint64_t u;
+                    if (std::from_chars(text.data(), text.data() + text.size(), u).ec == std::errc())
+                        return push(tape_tag::uint64, u);
+                }
+                double d;
+                if (json_errc e = parse_double(text, d); e != json_errc::none) return e;
+                uint64_t bits;
+                std::memcpy(&bits, &d, sizeof(bits));
+                return push(tape_tag::double_value, bits);
+            }
+            json_errc string(std::string_view s) { value(); return key(s); }
+            json_errc key(std::string_view k) {
+                m_tape.push_back(tape_word(tape_tag::string, m_strings.size()));
+                m_tape.push_back(k.size());
+                m_strings.append(k.data(), k.size());
+                return json_errc::none;
+            }
+            json_errc start_array() { return start(tape_tag::start_array); }
+            json_errc start_object() { return start(tape_tag::start_object); }
+            json_errc end_array() { return end(tape_tag::end_array); }
+            json_errc end_object() { return end(tape_tag::end_object); }
+        private:
+            void value() { if (!m_counts.empty()) ++m_counts.back(); }
+            json_errc push(tape_tag t, uint64_t raw) {
+                m_tape.push_back(tape_word(t));
+                m_tape.push_back(raw);
+                return json_errc::none;
+            }
+            json_errc start(tape_tag t) {
+                value();
+                m_starts.push_back(m_tape.size());
+                m_counts.push_back(0);
+                m_tape.push_back(tape_word(t));
+                m_tape.push_back(0);
+                return json_errc::none;
+            }
+            json_errc end(tape_tag t) {
+                size_t start = m_starts.back();
+                uint64_t count = m_counts.back();
+                m_keys.clear();
+                if (t == tape_tag::end_object && count > 1) count -= hide_duplicates(start);
+                if (count > tape_index_min) {
+                    m_tape[start + 1] = m_index.size();//relative until root is closed
+                    m_indexed.push_back(start + 1);
+                    if (t == tape_tag::end_array)
+                        for (size_t p = start + 2; p != m_tape.size(); p = tape_next(m_tape.data(), p))
+                            m_index.push_back(p);
+                    else//hide_duplicates left keys sorted
+                        for (size_t p : m_keys)
+                            if (tape_tag_of(m_tape[p]) == tape_tag::string) m_index.push_back(p);
+                }
+                m_tape[start] |= tape_payload(m_tape.size());
+                m_tape.push_back(tape_word(t, count));
+                m_starts.pop_back();
+                m_counts.pop_back();
+                if (m_starts.empty() && !m_index.empty()) {//root is closed, append element tables
+                    for (size_t w : m_indexed) m_tape[w] += m_tape.size();
+                    m_tape.insert(m_tape.end(), m_index.begin(), m_index.end());
+                }
+                return json_errc::none;
+            }
+            size_t hide_duplicates(size_t start) {//retag all but last of equal keys in object, returns number of hidden keys
+                for (size_t p = start + 2; p != m_tape.size(); p = tape_next(m_tape.data(), p + 2))
+                    m_keys.push_back(p);
+                auto key = [this](size_t p) { return std::string_view(m_strings.data() + tape_payload(m_tape[p]), size_t(m_tape[p + 1])); };
+                auto hide = [this](size_t p) { m_tape[p] = tape_word(tape_tag::hidden_key, tape_payload(m_tape[p])); };
+                size_t hidden = 0;
+                if (m_keys.size() <= tape_index_min) {//pairwise comparison is cheaper than sorting for small objects
+                    for (size_t k = 0; k + 1 < m_keys.size(); k++)
+                        for (size_t l = k + 1; l < m_keys.size(); l++)
+                            if (key(m_keys[k]) == key(m_keys[l])) {
+                                hide(m_keys[k]);
+                                ++hidden;
+                                break;
+                            }
+                    return hidden;
+                }
+                std::stable_sort(m_keys.begin(), m_keys.end(), [&](size_t a, size_t b) { return key(a) < key(b); });
+                for (size_t k = 0; k + 1 < m_keys.size(); k++)
+                    if (key(m_keys[k]) == key(m_keys[k + 1])) {
+                        hide(m_keys[k]);
+                        ++hidden;
+                    }
+                return hidden;
+            }
+
+            std::vector<uint64_t>& m_tape;
+            std::string& m_strings;
+            std::vector<size_t> m_starts;//index of opening word of each open container
+            std::vector<uint64_t> m_counts;
+            std::vector<size_t> m_keys;//keys of closed object, sorted by hide_duplicates if there are more than tape_index_min
+            std::vector<uint64_t> m_index;//element tables of closed containers
+            std::vector<size_t> m_indexed;//tape words which refer to m_index
+        };
+
+        template <typename Traits, typename = void>
+        struct has_serialization_cache : std::false_type {};
+        template <typename Traits>
+        struct has_serialization_cache<Traits, std::enable_if_t<Traits::serialization_cache>> : std::true_type {};
+        struct no_print_cache {};
+        constexpr size_t map_node_overhead = 4 * sizeof(void*);//color and links of red-black tree node
+        template <typename JSON_>
+        struct print_cache {
+            JSON_* parent = nullptr;
+            std::unique_ptr<std::string> text;//compact form of container
+            bool valid = false;
+        };
+
+        template <typename C, typename = void>
+        struct has_reserve : std::false_type {};
+        template <typename C>
+        struct has_reserve<C, std::void_t<decltype(std::declval<C&>().reserve(size_t()))>> : std::true_type {};
+        template <typename T, typename = void>
+        struct is_key_value : std::false_type {};//std::pair like type with string key
+        template <typename T>
+        struct is_key_value<T, std::void_t<decltype(std::declval<T&>().first), decltype(std::declval<T&>().second)>>
+            : std::is_convertible<decltype(std::declval<T&>().first), std::string_view> {};
+
         template <typename JSON_, typename array_it, typename object_it>
         class JSONIteratorBase {
         protected:
@@ -185,8 +1159,8 @@ namespace CompactJSON {
                 }
             }
             JSONIteratorBase(const JSONIteratorBase& o) { *this = o; }
-            explicit JSONIteratorBase(const JSONBase* p, array_it arr_i) : m_type(iter_t::array), iter_array(arr_i), parent(p) {}
-            explicit JSONIteratorBase(const JSONBase* p, object_it obj_i) : m_type(iter_t::object), iter_object(obj_i), parent(p) {}
+            explicit JSONIteratorBase(const std::remove_const_t<JSON_>* p, array_it arr_i) : iter_array(arr_i), parent(p), m_type(iter_t::array) {}
+            explicit JSONIteratorBase(const std::remove_const_t<JSON_>* p, object_it obj_i) : iter_object(obj_i), parent(p), m_type(iter_t::object) {}
             JSONIteratorBase& operator=(const JSONIteratorBase& o) noexcept {
                 this->~JSONIteratorBase();
                 switch (m_type = o.m_type) {
@@ -244,58 +1218,160 @@ namespace CompactJSON {
             }
             bool operator!=(const JSONIteratorBase& o) const { return !(*this == o); }
         protected:
-            friend class JSONBase;
+            template <typename> friend class CompactJSON::BasicJSON;
             union {
                 array_it iter_array;
                 object_it iter_object;
             }; //iter value
-            const JSONBase* parent = nullptr;
+            const std::remove_const_t<JSON_>* parent = nullptr;
             iter_t m_type = iter_t::none;
         };
+
+        //random access iterator over array elements (works with std::sort and parallel algorithms)
+        template <typename JSON_, typename It>
+        class JSONArrayIterator {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = std::remove_const_t<JSON_>;
+            using difference_type = ptrdiff_t;
+            using pointer = JSON_*;
+            using reference = JSON_&;
+            JSONArrayIterator() = default;
+            explicit JSONArrayIterator(It it) noexcept : m_it(it) {}
+            template <typename J, typename I, std::enable_if_t<std::is_convertible_v<I, It>, bool> = true>
+            JSONArrayIterator(const JSONArrayIterator<J, I>& o) noexcept : m_it(o.base()) {}//iterator to const_iterator
+
+            reference operator*() const noexcept { return **m_it; }
+            pointer operator->() const noexcept { return *m_it; }
+            reference operator[](difference_type n) const noexcept { return *m_it[n]; }
+            JSONArrayIterator& operator++() noexcept { ++m_it; return *this; }
+            JSONArrayIterator operator++(int) noexcept { return JSONArrayIterator(m_it++); }
+            JSONArrayIterator& operator--() noexcept { --m_it; return *this; }
+            JSONArrayIterator operator--(int) noexcept { return JSONArrayIterator(m_it--); }
+            JSONArrayIterator& operator+=(difference_type n) noexcept { m_it += n; return *this; }
+            JSONArrayIterator& operator-=(difference_type n) noexcept { m_it -= n; return *this; }
+            friend JSONArrayIterator operator+(JSONArrayIterator a, difference_type n) noexcept { return a += n; }
+            friend JSONArrayIterator operator+(difference_type n, JSONArrayIterator a) noexcept { return a += n; }
+            friend JSONArrayIterator operator-(JSONArrayIterator a, difference_type n) noexcept { return a -= n; }
+            friend difference_type operator-(const JSONArrayIterator& a, const JSONArrayIterator& b) noexcept { return a.m_it - b.m_it; }
+            friend bool operator==(const JSONArrayIterator& a, const JSONArrayIterator& b) noexcept { return a.m_it == b.m_it; }
+            friend bool operator!=(const JSONArrayIterator& a, const JSONArrayIterator& b) noexcept { return a.m_it != b.m_it; }
+            friend bool operator<(const JSONArrayIterator& a, const JSONArrayIterator& b) noexcept { return a.m_it < b.m_it; }
+            friend bool operator>(const JSONArrayIterator& a, const JSONArrayIterator& b) noexcept { return a.m_it > b.m_it; }
+            friend bool operator<=(const JSONArrayIterator& a, const JSONArrayIterator& b) noexcept { return a.m_it <= b.m_it; }
+            friend bool operator>=(const JSONArrayIterator& a, const JSONArrayIterator& b) noexcept { return a.m_it >= b.m_it; }
+            [[nodiscard]] It base() const noexcept { return m_it; }
+        private:
+            It m_it{};
+        };
+
+        //object iterator, dereferences to pair of key and value references
+        template <typename JSON_, typename It>
+        class JSONItemIterator {
+        public:
+            using key_type = typename std::remove_const_t<JSON_>::string_type;
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = std::pair<const key_type&, JSON_&>;
+            using difference_type = ptrdiff_t;
+            using reference = value_type;
+            struct pointer {//operator-> of proxy
+                value_type item;
+                const value_type* operator->() const noexcept { return &item; }
+            };
+            JSONItemIterator() = default;
+            explicit JSONItemIterator(It it) noexcept : m_it(it) {}
+            template <typename J, typename I, std::enable_if_t<std::is_convertible_v<I, It>, bool> = true>
+            JSONItemIterator(const JSONItemIterator<J, I>& o) noexcept : m_it(o.base()) {}
+
+            reference operator*() const noexcept { return { m_it->first, *m_it->second }; }
+            pointer operator->() const noexcept { return { **this }; }
+            [[nodiscard]] const key_type& key() const noexcept { return m_it->first; }
+            [[nodiscard]] JSON_& value() const noexcept { return *m_it->second; }
+            JSONItemIterator& operator++() noexcept { ++m_it; return *this; }
+            JSONItemIterator operator++(int) noexcept { return JSONItemIterator(m_it++); }
+            JSONItemIterator& operator--() noexcept { --m_it; return *this; }
+            JSONItemIterator operator--(int) noexcept { return JSONItemIterator(m_it--); }
+            friend bool operator==(const JSONItemIterator& a, const JSONItemIterator& b) noexcept { return a.m_it == b.m_it; }
+            friend bool operator!=(const JSONItemIterator& a, const JSONItemIterator& b) noexcept { return a.m_it != b.m_it; }
+            [[nodiscard]] It base() const noexcept { return m_it; }
+        private:
+            It m_it{};
+        };
+
+        //begin/end pair returned by array() and items()
+        template <typename It>
+        class json_range {
+        public:
+            json_range(It first, It last) noexcept : m_first(first), m_last(last) {}
+            [[nodiscard]] It begin() const noexcept { return m_first; }
+            [[nodiscard]] It end() const noexcept { return m_last; }
+            [[nodiscard]] size_t size() const noexcept { return size_t(std::distance(m_first, m_last)); }
+            [[nodiscard]] bool empty() const noexcept { return m_first == m_last; }
+        private:
+            It m_first, m_last;
+        };
     } //namespace details
-    class JSONBase {
+    template <typename Traits>
+    class BasicJSON {
         enum class val_t : uint8_t {
-            null_t = 0, float_t, int_t, bool_t, string_t, object_t, array_t
+            null_t = 0, float_t, int_t, bool_t, string_t, object_t, array_t, raw_number_t //raw_number_t keeps number text in raw
         };
     public:
-        using iterator = details::JSONIteratorBase<JSONBase, std::vector<JSONBase*>::iterator, std::map<std::string, JSONBase*>::iterator>;
-        using const_iterator = details::JSONIteratorBase<const JSONBase, std::vector<JSONBase*>::const_iterator, std::map<std::string, JSONBase*>::const_iterator>;
+        using traits_type = Traits;
+        using allocator_type = typename Traits::allocator_type;
+        using string_type = typename Traits::string_type;
+        using array_type = typename Traits::template array_type<BasicJSON*>;
+        using object_type = typename Traits::template object_type<string_type, BasicJSON*>;
+        static constexpr bool cache_enabled = details::has_serialization_cache<Traits>::value;
+
+        using iterator = details::JSONIteratorBase<BasicJSON, typename array_type::iterator, typename object_type::iterator>;
+        using const_iterator = details::JSONIteratorBase<const BasicJSON, typename array_type::const_iterator, typename object_type::const_iterator>;
         using reverse_iterator = std::reverse_iterator<iterator>;
         using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+        using array_iterator = details::JSONArrayIterator<BasicJSON, typename array_type::iterator>;
+        using const_array_iterator = details::JSONArrayIterator<const BasicJSON, typename array_type::const_iterator>;
+        using item_iterator = details::JSONItemIterator<BasicJSON, typename object_type::iterator>;
+        using const_item_iterator = details::JSONItemIterator<const BasicJSON, typename object_type::const_iterator>;
 
-        JSONBase() {}
-        ~JSONBase() { clear(); }
-        JSONBase(const JSONBase& v) { *this = v; }     //use copy assignment operator
-        JSONBase(JSONBase&& v) { *this = v; }          //use move assignment operator
-        JSONBase& operator=(const JSONBase& v) {
+        BasicJSON() {}
+        explicit BasicJSON(const allocator_type& alloc) : m_alloc(alloc) {}
+        ~BasicJSON() { clear(); }
+        BasicJSON(const BasicJSON& v)  //use copy assignment operator
+            : m_alloc(std::allocator_traits<allocator_type>::select_on_container_copy_construction(v.m_alloc)) { *this = v; }
+        BasicJSON(const BasicJSON& v, const allocator_type& alloc) : m_alloc(alloc) { *this = v; }//copy into other allocator
+        BasicJSON(BasicJSON&& v) : m_alloc(v.m_alloc) { *this = std::move(v); }//use move assignment operator
+        BasicJSON& operator=(const BasicJSON& v) {
             set_type_to(v.m_type);
-            switch (m_type) { //copy value
+            switch (m_type) { //copy value (nodes are allocated with this allocator)
             case val_t::float_t: d = v.d; break;
             case val_t::int_t: i = v.i; break;
             case val_t::bool_t: b = v.b; break;
             case val_t::string_t: str = v.str; break;
+            case val_t::raw_number_t: raw = v.raw; break;
             case val_t::object_t:
                 for (auto& [key, val] : v.obj)
-                    obj[key] = new JSONBase(*val);
+                    emplace_node(obj.end(), key, create_node(*val));
                 break;
             case val_t::array_t:
-                arr.resize(v.arr.size());
-                for (size_t i = 0; i < v.arr.size(); i++)
-                    arr[i] = new JSONBase(*v.arr[i]);
+                arr.reserve(v.arr.size());
+                for (auto val : v.arr)
+                    push_node(create_node(*val));
                 break;
             case val_t::null_t: default: break;
             }
+            invalidate_cache();
             return *this;
         }
-        JSONBase& operator=(JSONBase&& v) {
+        BasicJSON& operator=(BasicJSON&& v) {
+            if (m_alloc != v.m_alloc)//nodes can't be moved between different allocators
+                return *this = v;
             set_type_to(v.m_type);
             switch (m_type) { //move value
             case val_t::float_t: d = v.d; break;
             case val_t::int_t: i = v.i; break;
             case val_t::bool_t: b = v.b; break;
-            case val_t::string_t:
-                str = std::move(v.str);
-                break;
+            case val_t::string_t: str = std::move(v.str); break;
+            case val_t::raw_number_t: raw = std::move(v.raw); break;
             case val_t::object_t:
                 obj = std::move(v.obj);
                 v.obj.clear();
@@ -306,19 +1382,31 @@ namespace CompactJSON {
                 break;
             case val_t::null_t: default: break;
             }
+            adopt_children();
+            invalidate_cache();
+            v.invalidate_cache();
             return *this;
         }
         template <typename T, std::enable_if_t<std::is_floating_point_v<T>, bool> = true>
-        JSONBase(T val) : m_type(val_t::float_t), d(static_cast<double>(val)) {} //double
+        BasicJSON(T val) : d(static_cast<double>(val)), m_type(val_t::float_t) {} //double
         template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, bool> = true>
-        JSONBase(T val) : m_type(val_t::int_t), i(static_cast<int64_t>(val)) {} //int
+        BasicJSON(T val) : i(static_cast<int64_t>(val)), m_type(val_t::int_t) { //int
+            if constexpr (std::is_unsigned_v<T>)
+                if (val > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {//above int64_t range, kept exact as raw number
+                    char buf[24];
+                    auto res = std::to_chars(buf, buf + sizeof(buf), val);
+                    set_type_to(val_t::raw_number_t);
+                    raw.text.assign(buf, res.ptr);
+                }
+        }
         template <typename T, std::enable_if_t<std::is_same_v<T, bool>, bool> = true>
-        JSONBase(T val) : m_type(val_t::bool_t), b(val) {} //bool
-        template <typename T, std::enable_if_t<std::is_constructible_v<std::string, T> && !std::is_same_v<T, std::nullptr_t>, bool> = true>
-        JSONBase(T val) : m_type(val_t::string_t), str(val) {} //string
+        BasicJSON(T val) : b(val), m_type(val_t::bool_t) {} //bool
+        template <typename T, std::enable_if_t<std::is_constructible_v<string_type, T> && !std::is_same_v<T, std::nullptr_t>
+            && !std::is_convertible_v<T, allocator_type>, bool> = true>
+        BasicJSON(T val) : str(val), m_type(val_t::string_t) {} //string
         template <typename T, std::enable_if_t<std::is_same_v<T, std::nullptr_t>, bool> = true>
-        JSONBase(T val) : m_type(val_t::null_t) {} //null
-        JSONBase(std::initializer_list<JSONBase> val) {
+        BasicJSON(T val) : m_type(val_t::null_t) {} //null
+        BasicJSON(std::initializer_list<BasicJSON> val, const allocator_type& alloc = allocator_type()) : m_alloc(alloc) {
             bool is_object = true;
             for (auto& v : val)
                 if (!(v.is_array() && v.arr.size() == 2 && v.arr[0]->is_string())) {
@@ -327,61 +1415,134 @@ namespace CompactJSON {
                 }
             if (is_object) {
                 set_type_to(val_t::object_t);
-                for (auto& v : val)
-                    obj[v.arr[0]->str] = new JSONBase(*v.arr[1]);//copy
+                for (auto& v : val) {
+                    BasicJSON* node = create_node(*v.arr[1]);//copy
+                    auto f = obj.lower_bound(v.arr[0]->str);
+                    if (f != obj.end() && f->first == v.arr[0]->str) {
+                        destroy_node(f->second);
+                        f->second = node;
+                    }
+                    else emplace_node(f, v.arr[0]->str, node);
+                }
             }
             else {
                 set_type_to(val_t::array_t);
+                arr.reserve(val.size());
                 for (auto& v : val)
-                    arr.push_back(new JSONBase(v));//copy
+                    push_node(create_node(v));//copy
             }
         }
 
-        [[nodiscard]] static JSONBase from_string(const std::string& str, bool enable_comments = false) {
-            std::istringstream s(str);
-            return from_stream(s, enable_comments);
+        [[nodiscard]] static BasicJSON from_string(std::string_view str, bool enable_comments = false) {
+            auto r = try_parse(str, parse_options{ enable_comments });
+            if (!r) JSON_PARSE_ERROR(r.error().message());
+            return r ? std::move(r).value() : BasicJSON();
         }
-        [[nodiscard]] static JSONBase from_stream(std::istream& istr, bool enable_comments = false) {
-            JSONBase j;
+        [[nodiscard]] static BasicJSON from_stream(std::istream& istr, bool enable_comments = false) {
+            BasicJSON j;
             j.scan(istr, enable_comments);
             return j;
         }
+        //parse without exceptions. on failure result holds error code, byte offset and line/column
+        [[nodiscard]] static parse_result<BasicJSON> try_parse(std::string_view str, const parse_options& opts = {}, const allocator_type& alloc = allocator_type()) {
+            BasicJSON j(alloc);
+            details::dom_builder<BasicJSON> b(j, opts.lazy_numbers);
+            details::parser<details::dom_builder<BasicJSON>> p(str, opts);
+            if (json_errc e = p.parse(b); e != json_errc::none)
+                return details::make_parse_error(str, e, p.offset());
+            return j;
+        }
+        //parse only keys selected by projection, skipped values are validated but not decoded or allocated
+        [[nodiscard]] static parse_result<BasicJSON> try_parse(std::string_view str, const projection& proj, const parse_options& opts = {}, const allocator_type& alloc = allocator_type()) {
+            BasicJSON j(alloc);
+            details::dom_builder<BasicJSON> b(j, opts.lazy_numbers, &proj);
+            details::parser<details::dom_builder<BasicJSON>> p(str, opts);
+            if (json_errc e = p.parse(b); e != json_errc::none)
+                return details::make_parse_error(str, e, p.offset());
+            return j;
+        }
+        [[nodiscard]] static parse_result<BasicJSON> try_parse(std::istream& istr, const parse_options& opts = {}, const allocator_type& alloc = allocator_type()) {
+            std::string buf(std::istreambuf_iterator<char>(istr), {});
+            return try_parse(buf, opts, alloc);
+        }
         //TODO add from_file (with BOM check)
 
-        [[nodiscard]] bool is_float() const noexcept { return m_type == val_t::float_t; }
-        [[nodiscard]] bool is_integer() const noexcept { return m_type == val_t::int_t; }
+        //check json grammar, utf-8, nesting depth and number range without building JSONBase (no exceptions, allocates only for nesting deeper than 4096).
+        //accepts same documents as try_parse
+        [[nodiscard]] static validate_result validate(std::string_view str, bool enable_comments = false, size_t max_depth = JSON_DEFAULT_MAX_DEPTH) noexcept {
+            return details::validate(str, enable_comments, max_depth);
+        }
+
+        [[nodiscard]] allocator_type get_allocator() const noexcept { return m_alloc; }
+
+        [[nodiscard]] memory_usage_info memory_usage() const {
+            memory_usage_info info;
+            info.nodes = sizeof(BasicJSON);
+            add_memory_usage(info);
+            return info;
+        }
+        //reallocate whole tree in depth-first order with exact capacities. document is copied, so
+        //peak memory is doubled while compacting. copy goes to same allocator: this only trims capacity and
+        //helps if allocator reuses freed memory. for arena that never frees (monotonic_buffer_resource) use compact(alloc)
+        void compact() {
+            BasicJSON tmp(*this, m_alloc);
+            *this = std::move(tmp);
+        }
+        //copy whole tree into alloc (e.g. fresh arena) and release old nodes to previous allocator, which is no longer used.
+        //only for root value: child nodes must use allocator of their parent
+        void compact(const allocator_type& alloc) {
+            if constexpr (cache_enabled) JSON_ASSERT(m_cache.parent == nullptr);
+            BasicJSON tmp(*this, alloc);
+            this->~BasicJSON();
+            ::new (static_cast<void*>(this)) BasicJSON(std::move(tmp));//same allocator: moves containers, doesn't throw
+        }
+
+        //with serialization cache (Traits::serialization_cache) containers keep their compact text.
+        //it is invalidated by mutating methods, call this after writing through reference returned by get<T>() earlier
+        void invalidate_cache() noexcept {
+            if constexpr (cache_enabled)
+                for (BasicJSON* n = this; n; n = n->m_cache.parent) {
+                    if (!n->m_cache.valid && n != this) break;//ancestors of dirty node are already dirty
+                    n->m_cache.valid = false;
+                }
+        }
+
+        [[nodiscard]] bool is_float() const noexcept { return m_type == val_t::float_t || (m_type == val_t::raw_number_t && !raw_is_integer()); }
+        [[nodiscard]] bool is_integer() const noexcept { return m_type == val_t::int_t || (m_type == val_t::raw_number_t && raw_is_integer()); }
         [[nodiscard]] bool is_boolean() const noexcept { return m_type == val_t::bool_t; }
         [[nodiscard]] bool is_string() const noexcept { return m_type == val_t::string_t; }
         [[nodiscard]] bool is_object() const noexcept { return m_type == val_t::object_t; }
         [[nodiscard]] bool is_array() const noexcept { return m_type == val_t::array_t; }
         [[nodiscard]] bool is_null() const noexcept { return m_type == val_t::null_t; }
-        [[nodiscard]] bool is_number() const noexcept { return m_type == val_t::int_t || m_type == val_t::float_t; }
+        [[nodiscard]] bool is_number() const noexcept { return m_type == val_t::int_t || m_type == val_t::float_t || m_type == val_t::raw_number_t; }
+        [[nodiscard]] bool is_raw_number() const noexcept { return m_type == val_t::raw_number_t; }//number parsed with lazy_numbers option
 
 
-        [[nodiscard]] JSONBase& operator[](const std::string& key) {
+        [[nodiscard]] BasicJSON& operator[](std::string_view key) {
             if (is_null())
                 set_type_to(val_t::object_t);
             JSON_TYPE_ASSERT(is_object());
-            auto f = obj.find(key);
-            if (f == obj.end())
-                return *(obj[key] = new JSONBase);
-            else
-                return *f->second;
+            auto f = obj.lower_bound(key);
+            if (f == obj.end() || f->first != key) {
+                f = emplace_node(f, key, create_node());
+                invalidate_cache();
+            }
+            return *f->second;
         }
-        [[nodiscard]] const JSONBase& operator[](const std::string& key) const {
+        [[nodiscard]] const BasicJSON& operator[](std::string_view key) const {
             JSON_TYPE_ASSERT(is_object());
             auto f = obj.find(key);
             JSON_ASSERT(f != obj.end()); //must contains element
             return *f->second;
         }
-        [[nodiscard]] JSONBase& operator[](size_t i) {
+        [[nodiscard]] BasicJSON& operator[](size_t i) {
             if (is_null())
                 set_type_to(val_t::array_t);
             JSON_TYPE_ASSERT(is_array());
             if (arr.size() <= i) resize(i + 1);
             return *arr[i];
         }
-        [[nodiscard]] const JSONBase& operator[](size_t i) const {
+        [[nodiscard]] const BasicJSON& operator[](size_t i) const {
             JSON_TYPE_ASSERT(is_array());
             JSON_ASSERT(i < arr.size());
             return *arr[i];
@@ -396,26 +1557,84 @@ namespace CompactJSON {
             return obj.size();
         }
 
-        [[nodiscard]] bool contains(const std::string& key) const {
+        [[nodiscard]] bool contains(std::string_view key) const {
             JSON_TYPE_ASSERT(is_object());
             auto f = obj.find(key);
             return f != obj.end();
         }
 
-        void erase(const std::string& key) {
+        void erase(std::string_view key) {
             JSON_TYPE_ASSERT(is_object());
             auto f = obj.find(key);
             JSON_ASSERT(f != obj.end());
+            destroy_node(f->second);
             obj.erase(f);
+            invalidate_cache();
         }
 
         void resize(size_t new_size) {
             if (is_null()) set_type_to(val_t::array_t);
             JSON_TYPE_ASSERT(is_array());
-            size_t old_size = arr.size();
-            arr.resize(new_size, nullptr);
-            for (size_t j = old_size; j < arr.size(); j++)
-                arr[j] = new JSONBase;
+            for (size_t j = new_size; j < arr.size(); j++)
+                destroy_node(arr[j]);
+            if (new_size < arr.size()) arr.resize(new_size);
+            else {
+                if (new_size > arr.capacity()) arr.reserve(std::max(new_size, 2 * arr.capacity()));//geometric, operator[] grows one by one
+                while (arr.size() < new_size) push_node(create_node());
+            }
+            invalidate_cache();
+        }
+
+        //preallocate storage for n elements (null becomes array). objects are reserved only if object_type supports it
+        void reserve(size_t n) {
+            if (is_null()) set_type_to(val_t::array_t);
+            JSON_TYPE_ASSERT(is_array() || is_object());
+            if (is_array()) arr.reserve(n);
+            else if constexpr (details::has_reserve<object_type>::value) obj.reserve(n);
+        }
+        void push_back(const BasicJSON& v) { emplace_back(v); }
+        void push_back(BasicJSON&& v) { emplace_back(std::move(v)); }
+        template <typename... Args>
+        BasicJSON& emplace_back(Args&&... args) {//append value constructed from args (null becomes array)
+            if (is_null()) set_type_to(val_t::array_t);
+            JSON_TYPE_ASSERT(is_array());
+            push_node(create_value_node(std::forward<Args>(args)...));
+            invalidate_cache();
+            return *arr.back();
+        }
+        //insert value constructed from args if key is not present (null becomes object). string_type&& key is moved
+        template <typename K, typename... Args>
+        std::pair<iterator, bool> emplace(K&& key, Args&&... args) {
+            if (is_null()) set_type_to(val_t::object_t);
+            JSON_TYPE_ASSERT(is_object());
+            std::string_view k = key;
+            auto f = obj.lower_bound(k);
+            if (f != obj.end() && f->first == k)
+                return { iterator(this, f), false };
+            BasicJSON* node = create_value_node(std::forward<Args>(args)...);
+            if constexpr (std::is_same_v<std::decay_t<K>, string_type> && !std::is_lvalue_reference_v<K>)
+                f = emplace_node(f, std::move(key), node);
+            else
+                f = emplace_node(f, k, node);
+            invalidate_cache();
+            return { iterator(this, f), true };
+        }
+        //append values to array or insert key-value pairs to object (depends on range value type)
+        template <typename It>
+        void insert(It first, It last) {
+            using value_type = typename std::iterator_traits<It>::value_type;
+            constexpr bool is_pairs = details::is_key_value<value_type>::value;
+            if (is_null()) set_type_to(is_pairs ? val_t::object_t : val_t::array_t);
+            JSON_TYPE_ASSERT(is_pairs ? is_object() : is_array());
+            if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category>)
+                reserve((is_pairs ? obj.size() : arr.size()) + size_t(std::distance(first, last)));
+            for (; first != last; ++first) {
+                if constexpr (is_pairs) {
+                    auto&& kv = *first;
+                    emplace(kv.first, kv.second);
+                }
+                else emplace_back(*first);
+            }
         }
 
         void clear() {
@@ -427,24 +1646,78 @@ namespace CompactJSON {
             return is_array() ? arr.empty() : obj.empty();
         }
 
+        //numbers: const get<T>() returns value, non-const returns reference for floating point and signed integer T.
+        //raw and converted numbers accept same T: integers in int64_t range are signed or unsigned integers (range checked),
+        //integers above it are unsigned or floating point, other numbers floating point. reading keeps text of raw number,
+        //value of raw number is stored next to text when reference to it is returned (text is printed until value changes)
         template <typename T, std::enable_if_t<std::is_floating_point_v<T>, bool> = true>
-        [[nodiscard]] double& get() { JSON_TYPE_ASSERT(is_float()); return d; }
+        [[nodiscard]] double& get() {
+            if (!is_raw_number()) {
+                JSON_TYPE_ASSERT(m_type == val_t::float_t);
+                invalidate_cache();
+                return d;
+            }
+            store_raw_value(val_t::float_t);
+            return raw.d;
+        }
         template <typename T, std::enable_if_t<std::is_floating_point_v<T>, bool> = true>
-        [[nodiscard]] const double& get() const { JSON_TYPE_ASSERT(is_float()); return d; }
-        template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, bool> = true>
-        [[nodiscard]] int64_t& get() { JSON_TYPE_ASSERT(is_integer()); return i; }
-        template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, bool> = true>
-        [[nodiscard]] const int64_t& get() const { JSON_TYPE_ASSERT(is_integer()); return i; }
-        template <typename T, std::enable_if_t<std::is_same_v<T, bool>, bool> = true>
-        [[nodiscard]] bool& get() { JSON_TYPE_ASSERT(is_boolean()); return b; }
-        template <typename T, std::enable_if_t<std::is_same_v<T, bool>, bool> = true>
+        [[nodiscard]] double get() const {
+            if (!is_raw_number()) {
+                JSON_TYPE_ASSERT(m_type == val_t::float_t);
+                return d;
+            }
+            BasicJSON v = converted_number();
+            JSON_TYPE_ASSERT(v.m_type == val_t::float_t);
+            return v.d;
+        }
+        template <typename T, std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T>, bool> = true>
+        [[nodiscard]] int64_t& get() {
+            if (!is_raw_number()) {
+                JSON_TYPE_ASSERT(m_type == val_t::int_t);
+                invalidate_cache();
+                return i;
+            }
+            store_raw_value(val_t::int_t);
+            return raw.i;
+        }
+        template <typename T, std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T>, bool> = true>
+        [[nodiscard]] int64_t get() const {
+            if (!is_raw_number()) {
+                JSON_TYPE_ASSERT(m_type == val_t::int_t);
+                return i;
+            }
+            BasicJSON v = converted_number();
+            JSON_TYPE_ASSERT(v.m_type == val_t::int_t);
+            return v.i;
+        }
+        template <typename T, std::enable_if_t<std::is_unsigned_v<T> && !std::is_same_v<T, bool>, bool> = true>
+        [[nodiscard]] T get() const {//full uint64_t range
+            uint64_t v = 0;
+            bool converted = false;
+            if (is_raw_number() && raw_text_current())
+                converted = raw_is_integer() && std::from_chars(raw.text.data(), raw.text.data() + raw.text.size(), v).ec == std::errc();
+            else if (is_number()) {
+                BasicJSON n = is_raw_number() ? converted_number() : *this;
+                converted = n.m_type == val_t::int_t && n.i >= 0;
+                v = static_cast<uint64_t>(n.i);
+            }
+            JSON_TYPE_ASSERT(converted && v <= std::numeric_limits<T>::max());
+            return static_cast<T>(v);
+        }
+        template <typename T, std::enable_if_t<std::is_same_v<T, bool>, bool> = true>
+        [[nodiscard]] bool& get() { JSON_TYPE_ASSERT(is_boolean()); invalidate_cache(); return b; }
+        template <typename T, std::enable_if_t<std::is_same_v<T, bool>, bool> = true>
         [[nodiscard]] const bool& get() const { JSON_TYPE_ASSERT(is_boolean()); return b; }
-        template <typename T, std::enable_if_t<std::is_same_v<T, std::string>, bool> = true>
-        [[nodiscard]] std::string& get() { JSON_TYPE_ASSERT(is_string()); return str; }
-        template <typename T, std::enable_if_t<std::is_same_v<T, std::string>, bool> = true>
-        [[nodiscard]] const std::string& get() const { JSON_TYPE_ASSERT(is_string()); return str; }
+        template <typename T, std::enable_if_t<std::is_same_v<T, string_type>, bool> = true>
+        [[nodiscard]] string_type& get() { JSON_TYPE_ASSERT(is_string()); invalidate_cache(); return str; }
+        template <typename T, std::enable_if_t<std::is_same_v<T, string_type>, bool> = true>
+        [[nodiscard]] const string_type& get() const { JSON_TYPE_ASSERT(is_string()); return str; }
         template <typename T, std::enable_if_t<std::is_same_v<T, std::nullptr_t>, bool> = true>
         [[nodiscard]] std::nullptr_t get() const { JSON_TYPE_ASSERT(is_null()); return nullptr; }
+        [[nodiscard]] std::string_view raw_number() const {//original number text
+            JSON_TYPE_ASSERT(is_raw_number());
+            return raw.text;
+        }
 
         iterator begin() {
             JSON_TYPE_ASSERT(is_array() || is_object());
@@ -471,22 +1744,133 @@ namespace CompactJSON {
         const_reverse_iterator crbegin() const { return const_reverse_iterator(end()); }
         const_reverse_iterator crend() const { return const_reverse_iterator(begin()); }
 
+        //typed views: random access over array elements, key-value pairs of object
+        //for (auto& v : j.array()) ...; std::sort(j.array().begin(), j.array().end(), cmp);
+        //for (auto [key, v] : j.items()) ...
+        [[nodiscard]] details::json_range<array_iterator> array() {
+            JSON_TYPE_ASSERT(is_array());
+            return { array_iterator(arr.begin()), array_iterator(arr.end()) };
+        }
+        [[nodiscard]] details::json_range<const_array_iterator> array() const {
+            JSON_TYPE_ASSERT(is_array());
+            return { const_array_iterator(arr.begin()), const_array_iterator(arr.end()) };
+        }
+        [[nodiscard]] details::json_range<item_iterator> items() {
+            JSON_TYPE_ASSERT(is_object());
+            return { item_iterator(obj.begin()), item_iterator(obj.end()) };
+        }
+        [[nodiscard]] details::json_range<const_item_iterator> items() const {
+            JSON_TYPE_ASSERT(is_object());
+            return { const_item_iterator(obj.begin()), const_item_iterator(obj.end()) };
+        }
+
+        //exchange values without copying (copies only if allocators differ)
+        void swap(BasicJSON& o) {
+            if (this == &o) return;
+            BasicJSON tmp(std::move(o));
+            o = std::move(*this);
+            *this = std::move(tmp);
+        }
+        friend void swap(BasicJSON& a, BasicJSON& b) { a.swap(b); }
+
         [[nodiscard]] std::string to_string(int tab_size = -1) const {
             std::ostringstream s;
             print(s, tab_size);
             return s.str();
         }
+        //same text as to_string(tab_size). children of wide arrays and objects are split into chunks
+        //which are printed by threads (threads = 0 uses std::thread::hardware_concurrency()).
+        //small documents are printed by calling thread, at most one thread per JSON_PARALLEL_PRINT_MIN_VALUES values
+        [[nodiscard]] std::string to_string_parallel(int tab_size = -1, unsigned threads = 0) const {
+            if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+            if (threads == 1 || !(is_array() || is_object()) || empty()) return to_string(tab_size);
+            threads = unsigned(std::min<size_t>(threads, count_values(size_t(threads) * JSON_PARALLEL_PRINT_MIN_VALUES) / JSON_PARALLEL_PRINT_MIN_VALUES));
+            if (threads <= 1) return to_string(tab_size);
+            if constexpr (cache_enabled)
+                if (tab_size < 0 && m_cache.valid) return *m_cache.text;
+            std::vector<print_piece> pieces;
+            split_print(pieces, tab_size, 0, size_t(threads) * 4, 4);
+            std::vector<std::string> parts(pieces.size());
+            std::atomic<size_t> next{ 0 };
+            std::exception_ptr error;
+            std::mutex error_mutex;
+            auto work = [&]() {
+                try {
+                    for (size_t k; (k = next++) < pieces.size();)
+                        parts[k] = render_piece(pieces[k], tab_size);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error) error = std::current_exception();
+                    next = pieces.size();
+                }
+            };
+            std::vector<std::thread> pool;
+            try {
+                for (unsigned t = 1; t < threads; t++) pool.emplace_back(work);
+            }
+            catch (...) {}//fewer threads, remaining pieces are printed by this thread
+            work();
+            for (auto& t : pool) t.join();
+            if (error) std::rethrow_exception(error);
+            size_t total = 0;
+            for (auto& p : parts) total += p.size();
+            std::string out;
+            out.reserve(total);
+            for (auto& p : parts) out += p;
+            return out;
+        }
 
     protected:
-        friend std::ostream& operator<<(std::ostream& ostr, const JSONBase& j);
-        friend std::istream& operator>>(std::istream& ostr, JSONBase& j);
-        friend bool operator==(const JSONBase& a, const JSONBase& b);
-        friend bool operator!=(const JSONBase& a, const JSONBase& b);
+        friend std::ostream& operator<<(std::ostream& ostr, const BasicJSON& j) { return j.print(ostr), ostr; }
+        friend std::istream& operator>>(std::istream& istr, BasicJSON& j) { return j.scan(istr), istr; }
+        friend bool operator==(const BasicJSON& a, const BasicJSON& b) {
+            if (a.m_type != b.m_type) {//raw numbers are compared with converted value
+                if (a.is_raw_number() && b.is_number()) return a.converted_number() == b;
+                if (b.is_raw_number() && a.is_number()) return a == b.converted_number();
+                return false;
+            }
+            switch (a.m_type) {
+            case val_t::float_t: return std::abs(a.d - b.d) < 1e-10;
+            case val_t::int_t: return a.i == b.i;
+            case val_t::bool_t: return a.b == b.b;
+            case val_t::string_t: return a.str == b.str;
+            case val_t::raw_number_t: return a.raw_equal(b);
+            case val_t::object_t:
+                if (a.obj.size() != b.obj.size())
+                    return false;
+                for (auto ai = a.obj.begin(), bi = b.obj.begin(); ai != a.obj.end(); ai++, bi++)
+                    if (ai->first != bi->first || *ai->second != *bi->second)
+                        return false;
+                return true;
+            case val_t::array_t:
+                if (a.arr.size() != b.arr.size())
+                    return false;
+                for (size_t i = 0; i < a.arr.size(); i++)
+                    if (*a.arr[i] != *b.arr[i])
+                        return false;
+                return true;
+            case val_t::null_t: return true;
+            default: break;
+            }
+            return false;
+        }
+        friend bool operator!=(const BasicJSON& a, const BasicJSON& b) { return !(a == b); }
+        template <typename> friend class details::dom_builder;
+        friend class TapeValue;
 #ifdef JSON_PROTECTED_DEFINITIONS//define it to add friend functions/classes or additional member data
         JSON_PROTECTED_DEFINITIONS;
 #endif//JSON_PROTECTED_DEFINITIONS
 
         void print(std::ostream& ostr, int tab_size = -1, size_t space_offset = 0) const {
+            if constexpr (cache_enabled)
+                if (tab_size < 0 && (is_array() || is_object())) {
+                    ostr << cached_text();
+                    return;
+                }
+            print_value(ostr, tab_size, space_offset);
+        }
+        void print_value(std::ostream& ostr, int tab_size, size_t space_offset) const {
             auto offset = std::string(space_offset, ' ');
             auto delta = tab_size < 0 ? std::string() : std::string(tab_size, ' ');
             auto newline = tab_size < 0 ? std::string() : std::string(1, '\n');
@@ -502,7 +1886,7 @@ namespace CompactJSON {
                 }
                 size_t r = obj.size() - 1;
                 ostr << '{' << newline;
-                for (auto [key, v] : obj) {
+                for (const auto& [key, v] : obj) {
                     ostr << offset << delta << '"' << details::escape_sec_to_string(key) << '"' << ':' << space;
                     v->print(ostr, tab_size, space_offset + (tab_size > 0 ? tab_size : 0));
                     (r-- ? ostr << ',' << newline : ostr << newline << offset << '}');
@@ -523,301 +1907,925 @@ namespace CompactJSON {
                 }
                 break;
             }
-            case val_t::float_t: {
-                if (!std::isfinite(d)) {
-                    ostr << "null";
-                    break;
-                }
-                if (std::abs(std::log10(d)) > 16) ostr << std::scientific;
-                else ostr << std::defaultfloat << std::setprecision((std::numeric_limits<double>::max_digits10 + 1));
-                //ostr << std::scientific << std::setprecision((std::numeric_limits<double>::max_digits10 + 1));
-                ostr << d;//TODO fix loat precision
-            } break;
+            case val_t::float_t: details::print_double(ostr, d); break;
             case val_t::int_t: ostr << i; break;
+            case val_t::raw_number_t:
+                if (raw_text_current()) ostr << raw.text;
+                else if (raw.cooked == val_t::int_t) ostr << raw.i;
+                else details::print_double(ostr, raw.d);
+                break;
             case val_t::bool_t: ostr << (b ? "true" : "false"); break;
             case val_t::null_t: ostr << "null"; break;
             default: break;
             }
         }
         void scan(std::istream& in, bool enable_comments = false) {
-            int ch;
-            JSONBase ret, * cur = &ret;
-            //auto is_correct_char = [](int ch) -> bool { return -1 <= ch && ch <= 255};
-            int ch2 = 0;
-            auto skip_spaces_and_comments = [&]() {
-                while (in.good() && (std::isspace(ch) || ch == '/')) {
-                    if (ch == '/') {
-                        if (!enable_comments) JSON_PARSE_ERROR("json: comments is not enabled");
-                        ch2 = in.get();
-                        if (ch2 == '/') {
-                            while (in.good() && ch != '\n') ch = in.get();
-                            ch = in.get();
-                        }
-                        else if (ch2 == '*') {
-                            ch2 = in.get();
-                            ch = in.get();
-                            while (in.good() && !(ch2 == '*' && ch == '/')) {
-                                ch2 = ch;
-                                ch = in.get();
-                            }
-                            if (!in.good()) JSON_PARSE_ERROR("json: unexpected end of file");
-                            ch = in.get();
-                        }
-                        else JSON_PARSE_ERROR("json: unexpected character");
-                    }
-                    else ch = in.get();
+            auto r = try_parse(in, parse_options{ enable_comments }, m_alloc);
+            if (!r) JSON_PARSE_ERROR(r.error().message());
+            if (r) *this = std::move(r).value();
+        }
+
+    private:
+        //number text kept by lazy_numbers (and integers above int64_t range). value is stored next to it
+        //only when get<T>() returns reference
+        struct raw_number_type {
+            explicit raw_number_type(const allocator_type& alloc) : text(alloc) {}
+            string_type text;
+            union { double d; int64_t i = 0; };
+            val_t cooked = val_t::null_t;//int_t or float_t when value is stored
+        };
+        union {
+            double d; int64_t i = 0; bool b; string_type str; raw_number_type raw; //simple types
+            object_type obj; //object
+            array_type arr;  //array
+        };
+        val_t m_type = val_t::null_t;
+        allocator_type m_alloc;//used for child nodes and containers
+        mutable std::conditional_t<cache_enabled, details::print_cache<BasicJSON>, details::no_print_cache> m_cache;
+
+        [[nodiscard]] const std::string& cached_text() const {//compact form of container, rebuilt if it is dirty
+            if (!m_cache.valid) {
+                std::ostringstream s;
+                print_value(s, -1, 0);
+                if (!m_cache.text) m_cache.text = std::make_unique<std::string>();
+                *m_cache.text = std::move(s).str();
+                m_cache.valid = true;
+            }
+            return *m_cache.text;
+        }
+        static size_t string_heap_size(const string_type& s) noexcept {
+            static const size_t small_capacity = string_type().capacity();
+            return s.capacity() > small_capacity ? s.capacity() + 1 : 0;
+        }
+        void add_memory_usage(memory_usage_info& info) const {
+            switch (m_type) {
+            case val_t::string_t: info.strings += string_heap_size(str); break;
+            case val_t::raw_number_t: info.strings += string_heap_size(raw.text); break;
+            case val_t::array_t:
+                info.arrays += arr.capacity() * sizeof(BasicJSON*);
+                for (auto v : arr) {
+                    info.nodes += sizeof(BasicJSON);
+                    v->add_memory_usage(info);
+                }
+                break;
+            case val_t::object_t:
+                for (auto& [key, v] : obj) {
+                    info.objects += details::map_node_overhead + sizeof(typename object_type::value_type);
+                    info.strings += string_heap_size(key);
+                    info.nodes += sizeof(BasicJSON);
+                    v->add_memory_usage(info);
                 }
+                break;
+            default: break;
+            }
+            if constexpr (cache_enabled)
+                if (m_cache.text) info.strings += sizeof(std::string) + m_cache.text->capacity() + 1;
+        }
+        [[nodiscard]] size_t count_values(size_t limit) const {//number of values in subtree, stops counting at limit
+            size_t n = 1;
+            if (is_array())
+                for (size_t k = 0; k < arr.size() && n < limit; k++) n += arr[k]->count_values(limit - n);
+            else if (is_object())
+                for (auto it = obj.begin(); it != obj.end() && n < limit; ++it) n += it->second->count_values(limit - n);
+            return n;
+        }
+        //part of to_string_parallel output: text, then children [first, last) of parent
+        struct print_piece {
+            std::string text;
+            const BasicJSON* parent = nullptr;
+            size_t first = 0, last = 0;//array children
+            typename object_type::const_iterator obj_first{}, obj_last{};//object children
+            size_t space_offset = 0;//offset of parent
+        };
+        //this is non-empty container. wide containers (or containers at depth limit) are split into chunks of
+        //children, narrow ones are printed around pieces of their children
+        void split_print(std::vector<print_piece>& out, int tab_size, size_t space_offset, size_t chunks, size_t depth) const {
+            auto offset = std::string(space_offset, ' ');
+            auto delta = tab_size < 0 ? std::string() : std::string(tab_size, ' ');
+            auto newline = tab_size < 0 ? std::string() : std::string(1, '\n');
+            auto space = tab_size < 0 ? std::string() : std::string(1, ' ');
+            size_t child_offset = space_offset + (tab_size > 0 ? tab_size : 0);
+            size_t n = is_array() ? arr.size() : obj.size();
+            auto range = [&](size_t first, size_t last, typename object_type::const_iterator obj_first, typename object_type::const_iterator obj_last) {
+                print_piece p;
+                p.parent = this;
+                p.first = first, p.last = last;
+                p.obj_first = obj_first, p.obj_last = obj_last;
+                p.space_offset = space_offset;
+                out.push_back(std::move(p));
             };
-            std::function<std::string(void)> scan_string;
-            scan_string = [&]() -> std::string {
-                std::string s;
-                while (in.good() && (ch = in.get()) != '"') {
-                    if (in.good() && ch == '\\') {
-                        ch = in.get();
-                        switch (ch) {
-                        case 'b': s += '\b'; break;
-                        case 'f': s += '\f'; break;
-                        case 'n': s += '\n'; break;
-                        case 'r': s += '\r'; break;
-                        case 't': s += '\t'; break;
-                        case '"': s += '"'; break;
-                        case '\\': s += '\\'; break;
-                        case 'u': {//unicode char escape sec
-                            uint32_t symbol = 0;
-                            for (size_t i = 0; i < 4; i++) {//4 hex digits
-                                ch = in.get();
-                                symbol = symbol * 16 + (std::isdigit(ch) ? ch - '0' : ch + 10 - (std::isupper(ch) ? 'A' : 'a'));
-                            }
-                            //now symbol is unicode codepoint for symbol
-                            if (symbol < (2 << 7)) s += symbol;//1 wide
-                            else if (symbol < (2 << 11)) {//2 wide
-                                s += 0b11000000 | ((symbol & ~0b00111111) >> 6);
-                                s += 0b11000000 | (symbol & 0b00111111);
-                            } 
-                            else if (symbol < (2 << 16)) {//3 wide
-                                uint32_t v[3];
-                                v[2] = symbol & 0b00111111, symbol >>= 6;
-                                v[1] = symbol & 0b00111111, symbol >>= 6;
-                                v[0] = symbol;
-                                s += 0b11100000 | v[0], s += 0b10000000 | v[1], s += 0b10000000 | v[2];
-                            }
-                            else {//4 wide
-                                uint32_t v[4];
-                                v[3] = symbol & 0b00111111, symbol >>= 6;
-                                v[2] = symbol & 0b00111111, symbol >>= 6;
-                                v[1] = symbol & 0b00111111, symbol >>= 6;
-                                v[0] = symbol;
-                                s += 0b11110000 | v[0], s += 0b10000000 | v[1], s += 0b10000000 | v[2], s += 0b10000000 | v[3];
-                            }
-                            break;
-                        }
-                        default: JSON_PARSE_ERROR("json: invalid escape sequence"); break;
-                        }
-                    }
+            out.push_back({ std::string(1, is_array() ? '[' : '{') + newline });
+            if (n >= chunks || depth == 0) {
+                size_t k = std::min(n, chunks);
+                typename object_type::const_iterator it{};
+                if (is_object()) it = obj.begin();
+                for (size_t c = 0; c < k; c++) {
+                    size_t first = n * c / k, last = n * (c + 1) / k;
+                    if (is_array()) range(first, last, {}, {});
                     else {
-                        //if (ch > 127) JSON_PARSE_ERROR("json: non-ascii symbol");
-                        
-                        //scan string as utf-8
-                        if (ch < 0b11000000) {//1 wide
-                            s += ch;
-                        }
-                        else if (ch < 0b11100000) {//2 wide
-                            if(!((ch & 0b11100000) == 0b11000000)) JSON_PARSE_ERROR("json: invalid utf8");
-                            s += ch;
-                            ch = in.get();
-                            if(!in.good() || ((ch & 0b11000000) != 0b10000000)) JSON_PARSE_ERROR("json: invalid utf8");
-                            s += ch;
-                        }
-                        else if (ch < 0b11110000) {//3 wide
-                            if(!((ch & 0b11110000) == 0b11100000)) JSON_PARSE_ERROR("json: invalid utf8");
-                            s += ch;
-                            ch = in.get();
-                            if(!in.good() || ((ch & 0b11000000) != 0b10000000)) JSON_PARSE_ERROR("json: invalid utf8");
-                            s += ch;
-                            ch = in.get();
-                            if(!in.good() || ((ch & 0b11000000) != 0b10000000)) JSON_PARSE_ERROR("json: invalid utf8");
-                            s += ch;
-                        }
-                        else {//4 wide
-                            if(!((ch & 0b11111000) == 0b11110000)) JSON_PARSE_ERROR("json: invalid utf8");
-                            s += ch;
-                            ch = in.get();
-                            if(!in.good() || ((ch & 0b11000000) != 0b10000000)) JSON_PARSE_ERROR("json: invalid utf8");
-                            s += ch;
-                            ch = in.get();
-                            if(!in.good() || ((ch & 0b11000000) != 0b10000000)) JSON_PARSE_ERROR("json: invalid utf8");
-                            s += ch;
-                            ch = in.get();
-                            if(!in.good() || ((ch & 0b11000000) != 0b10000000)) JSON_PARSE_ERROR("json: invalid utf8");
-                            s += ch;
-                        }
+                        auto begin = it;
+                        std::advance(it, last - first);
+                        range(0, 0, begin, it);
                     }
                 }
-                if (!in.good())
-                    JSON_PARSE_ERROR("json: unexpected end of file");
-                ch = in.get();
-                return s;
-            };
-        
-            std::function<JSONBase(void)> scan_value;
-            scan_value = [&]() -> JSONBase {
-                JSONBase ret;
-                skip_spaces_and_comments();
-                switch (ch) {
-                case '[': {//begin array
-                    ret.set_type_to(val_t::array_t);
-                    size_t i = 0;
-                    while (ch != ']') {
-                        ch = in.get();
-                        skip_spaces_and_comments();
-                        if (ch == ']') continue;
-                        ret[i++] = scan_value();
-                        skip_spaces_and_comments();
-                        if (ch != ',' && ch != ']')
-                            JSON_PARSE_ERROR("json: ',' or ']' expected");
-                    }
-                    if (in.good()) ch = in.get();
-                    break;
+            }
+            else {
+                typename object_type::const_iterator it{};
+                if (is_object()) it = obj.begin();
+                for (size_t i = 0; i < n; i++) {
+                    const BasicJSON& v = is_array() ? *arr[i] : *it->second;
+                    bool expand = (v.is_array() || v.is_object()) && !v.empty();
+                    if constexpr (cache_enabled)
+                        expand = expand && !(tab_size < 0 && v.m_cache.valid);
+                    if (!expand) {
+                        if (is_array()) range(i, i + 1, {}, {});
+                        else range(0, 0, it, std::next(it));
+                    }
+                    else {
+                        std::string t = i ? ',' + newline : std::string();
+                        t += offset + delta;
+                        if (is_object()) t += '"' + details::escape_sec_to_string(it->first) + '"' + ':' + space;
+                        out.push_back({ std::move(t) });
+                        v.split_print(out, tab_size, child_offset, chunks, depth - 1);
+                    }
+                    if (is_object()) ++it;
                 }
-                case '{': { //begin object
-                    ret.set_type_to(val_t::object_t);
-                    while (ch != '}') { //begin array
-                        ch = in.get();
-                        skip_spaces_and_comments();
-                        if (ch == '}') continue;
-                        if (ch != '"')
-                            JSON_PARSE_ERROR("json: '\"' expected");
-                        std::string key = scan_string();
-                        skip_spaces_and_comments();
-                        if (ch != ':')
-                            JSON_PARSE_ERROR("json: ':' expected");
-                        if (!in.good())
-                            JSON_PARSE_ERROR("json: unexpected end of file");
-                        ch = in.get();
-                        ret[key] = scan_value();
-                        skip_spaces_and_comments();
-                        if (ch != ',' && ch != '}')
-                            JSON_PARSE_ERROR("json: ',' or '}' expected");
-                    }
-                    if (in.good()) ch = in.get();
-                    break;
+            }
+            out.push_back({ newline + offset + (is_array() ? ']' : '}') });
+        }
+        static std::string render_piece(const print_piece& p, int tab_size) {
+            if (!p.parent) return p.text;
+            const BasicJSON& c = *p.parent;
+            std::ostringstream s;
+            auto offset = std::string(p.space_offset, ' ');
+            auto delta = tab_size < 0 ? std::string() : std::string(tab_size, ' ');
+            auto newline = tab_size < 0 ? std::string() : std::string(1, '\n');
+            auto space = tab_size < 0 ? std::string() : std::string(1, ' ');
+            size_t child_offset = p.space_offset + (tab_size > 0 ? tab_size : 0);
+            if (c.is_array())
+                for (size_t i = p.first; i < p.last; i++) {
+                    if (i) s << ',' << newline;
+                    s << offset << delta;
+                    c.arr[i]->print(s, tab_size, child_offset);
                 }
-                case '"':
-                ret = scan_string();
-                break; //string
-                case '0': case '1': case '2': case '3': case '4': //number (floating point or integer)
-                case '5': case '6': case '7': case '8': case '9':
-                case '.': case '-': case '+': { //can begin from . (.2 same as 0.2) or from - or + (plus is non standart)
-                    //[int][.][fract][e[+|-]exp][literal]
-                    auto n = details::scan_number(ch, in);
-                    if(std::holds_alternative<int64_t>(n)) ret = std::get<int64_t>(n);
-                    else ret = std::get<double>(n);
-                    break;
+            else
+                for (auto it = p.obj_first; it != p.obj_last; ++it) {
+                    if (it != c.obj.begin()) s << ',' << newline;
+                    s << offset << delta << '"' << details::escape_sec_to_string(it->first) << '"' << ':' << space;
+                    it->second->print(s, tab_size, child_offset);
                 }
-                case 'n': {//null
-                    if (in.good() && (ch = in.get()) == 'u' && in.good() && (ch = in.get()) == 'l' && in.good() && (ch = in.get()) == 'l')
-                        ret = nullptr;
-                    else JSON_PARSE_ERROR("json: unexpected character");
-                    ch = in.get();
-                    break;
+            return std::move(s).str();
+        }
+        void adopt(BasicJSON* child) noexcept {
+            if constexpr (cache_enabled) child->m_cache.parent = this;
+        }
+        void adopt_children() noexcept {//after containers were moved from other node
+            if constexpr (cache_enabled) {
+                if (is_array()) for (auto v : arr) adopt(v);
+                else if (is_object()) for (auto& [key, v] : obj) adopt(v);
+            }
+        }
+
+        using node_allocator = typename std::allocator_traits<allocator_type>::template rebind_alloc<BasicJSON>;
+        using node_alloc_traits = std::allocator_traits<node_allocator>;
+        template <typename... Args>
+        BasicJSON* create_node(Args&&... args) {//child node with same allocator
+            node_allocator a(m_alloc);
+            BasicJSON* p = node_alloc_traits::allocate(a, 1);
+            try {
+                ::new (static_cast<void*>(p)) BasicJSON(std::forward<Args>(args)..., m_alloc);
+            }
+            catch (...) {
+                node_alloc_traits::deallocate(a, p, 1);
+                throw;
+            }
+            adopt(p);
+            return p;
+        }
+        template <typename... Args>
+        BasicJSON* create_value_node(Args&&... args) {//child node from value ctor args (or from other json)
+            if constexpr (std::allocator_traits<allocator_type>::is_always_equal::value) {
+                node_allocator a(m_alloc);
+                BasicJSON* p = node_alloc_traits::allocate(a, 1);
+                try {
+                    ::new (static_cast<void*>(p)) BasicJSON(std::forward<Args>(args)...);
                 }
-                case 't': {//true
-                    if (in.good() && (ch = in.get()) == 'r' && in.good() && (ch = in.get()) == 'u' && in.good() && (ch = in.get()) == 'e')
-                        ret = true;
-                    else JSON_PARSE_ERROR("json: unexpected character");
-                    ch = in.get();
-                    break;
+                catch (...) {
+                    node_alloc_traits::deallocate(a, p, 1);
+                    throw;
                 }
-                case 'f': {//false
-                    if (in.good() && (ch = in.get()) == 'a' && in.good() && (ch = in.get()) == 'l' && in.good() && (ch = in.get()) == 's'
-                        && in.good() && (ch = in.get()) == 'e')
-                        ret = false;
-                    else JSON_PARSE_ERROR("json: unexpected character");
-                    ch = in.get();
-                    break;
+                adopt(p);
+                return p;
+            }
+            else {//value must be rebuilt with node allocator
+                BasicJSON* p = create_node();
+                try {
+                    *p = BasicJSON(std::forward<Args>(args)...);
                 }
-                default: {//error
-                    JSON_PARSE_ERROR("json: unexpected character");
-                    break;
+                catch (...) {
+                    destroy_node(p);
+                    throw;
                 }
+                return p;
+            }
+        }
+        //containers never hold null: node is created first and destroyed if container can't store it
+        void push_node(BasicJSON* p) {
+            try { arr.push_back(p); }
+            catch (...) { destroy_node(p); throw; }
+        }
+        template <typename K>
+        typename object_type::iterator emplace_node(typename object_type::const_iterator hint, K&& key, BasicJSON* p) {
+            try {
+                if constexpr (std::is_same_v<std::decay_t<K>, string_type>) return obj.emplace_hint(hint, std::forward<K>(key), p);
+                else {
+                    std::string_view k = key;
+                    return obj.emplace_hint(hint, string_type(k.data(), k.size(), m_alloc), p);
                 }
-                return ret;
-            };
-            if (in.good()) ch = in.get();
-            if (in.good()) *this = scan_value();
-            if (in.good()) {
-                if (!is_array() && !is_object()) ch = in.get();
-                skip_spaces_and_comments();
-                if (in.good() && !std::isspace(ch)) JSON_PARSE_ERROR("json: unexpected character");
             }
+            catch (...) { destroy_node(p); throw; }
+        }
+        void destroy_node(BasicJSON* p) const {
+            node_allocator a(m_alloc);
+            p->~BasicJSON();
+            node_alloc_traits::deallocate(a, p, 1);
+        }
+        //set value from valid number text. integers out of int64_t range are kept exact as raw numbers
+        json_errc set_number(std::string_view text, bool is_integer) {
+            int64_t n;
+            if (is_integer && std::from_chars(text.data(), text.data() + text.size(), n).ec == std::errc()) {
+                set_type_to(val_t::int_t);
+                i = n;
+                return json_errc::none;
+            }
+            double v;
+            if (json_errc e = details::parse_double(text, v); e != json_errc::none) return e;
+            if (is_integer) {
+                set_type_to(val_t::raw_number_t);
+                raw.text.assign(text.data(), text.size());
+                return json_errc::none;
+            }
+            set_type_to(val_t::float_t);
+            d = v;
+            return json_errc::none;
+        }
+        [[nodiscard]] bool raw_is_integer() const noexcept { return raw.text.find_first_of(".eE") == string_type::npos; }
+        [[nodiscard]] bool raw_text_current() const {//false if value was changed through reference returned by get<T>()
+            if (raw.cooked == val_t::null_t) return true;
+            BasicJSON v = converted_text();
+            return raw.cooked == val_t::int_t ? v.i == raw.i : v.d == raw.d;
+        }
+        [[nodiscard]] bool raw_equal(const BasicJSON& other) const {//numeric comparison of two raw numbers
+            if (!raw_text_current() || !other.raw_text_current())
+                return converted_number() == other.converted_number();
+            const auto& a = raw.text; const auto& b = other.raw.text;
+            if (a == b) return true;
+            if (raw_is_integer() && other.raw_is_integer()) {//json integers have no leading zeros, so text differs for wider values
+                int64_t ai = 0, bi = 0;
+                uint64_t au = 0, bu = 0;
+                if (std::from_chars(a.data(), a.data() + a.size(), ai).ec == std::errc() &&
+                    std::from_chars(b.data(), b.data() + b.size(), bi).ec == std::errc())
+                    return ai == bi;
+                if (std::from_chars(a.data(), a.data() + a.size(), au).ec == std::errc() &&
+                    std::from_chars(b.data(), b.data() + b.size(), bu).ec == std::errc())
+                    return au == bu;
+                return false;
+            }
+            return converted_number() == other.converted_number();
+        }
+        [[nodiscard]] BasicJSON converted_text() const {//int_t for integers in int64_t range, float_t for other numbers
+            int64_t n;
+            if (raw_is_integer() && std::from_chars(raw.text.data(), raw.text.data() + raw.text.size(), n).ec == std::errc())
+                return BasicJSON(n);
+            double v = 0;
+            bool converted = details::parse_double(raw.text, v) == json_errc::none;
+            JSON_TYPE_ASSERT(converted);
+            return BasicJSON(v);
+        }
+        [[nodiscard]] BasicJSON converted_number() const {//converted text or value stored next to it
+            if (raw.cooked == val_t::int_t) return BasicJSON(raw.i);
+            if (raw.cooked == val_t::float_t) return BasicJSON(raw.d);
+            return converted_text();
+        }
+        void store_raw_value(val_t t) {//raw number keeps its text, converted value is stored once so reference to it can be returned
+            if (raw.cooked == val_t::null_t) {
+                BasicJSON v = converted_text();
+                JSON_TYPE_ASSERT(v.m_type == t);
+                if (t == val_t::int_t) raw.i = v.i;
+                else raw.d = v.d;
+                raw.cooked = t;
+            }
+            JSON_TYPE_ASSERT(raw.cooked == t);
+            invalidate_cache();
         }
-
-    private:
-        union {
-            double d; int64_t i = 0; bool b; std::string str; //simple types                 
-            std::map<std::string, JSONBase*> obj; //object
-            std::vector<JSONBase*> arr;           //array
-        };
-        val_t m_type = val_t::null_t;
         val_t set_type_to(val_t t) {
+            invalidate_cache();
             switch (m_type) { //destruct value
-            case val_t::string_t:
-                str.~basic_string();
-                break;
+            case val_t::string_t: str.~string_type(); break;
+            case val_t::raw_number_t: raw.~raw_number_type(); break;
             case val_t::object_t:
                 for (auto& [key, v] : obj)
-                    delete v;
-                obj.~map();
+                    destroy_node(v);
+                obj.~object_type();
                 break;
             case val_t::array_t:
                 for (auto v : arr)
-                    delete v;
-                arr.~vector();
+                    destroy_node(v);
+                arr.~array_type();
                 break;
             default: break;
             }
             m_type = t;
             switch (m_type) { //construct value
-            case val_t::string_t: new (&str) std::string; break;
-            case val_t::object_t: new (&obj) std::map<std::string, JSONBase*>; break;
-            case val_t::array_t: new (&arr) std::vector<JSONBase*>; break;
+            case val_t::string_t: new (&str) string_type(m_alloc); break;
+            case val_t::raw_number_t: new (&raw) raw_number_type(m_alloc); break;
+            case val_t::object_t: new (&obj) object_type(m_alloc); break;
+            case val_t::array_t: new (&arr) array_type(m_alloc); break;
             default: i = 0; break;
             }
             return t;
         }
     };
-    std::ostream& operator<<(std::ostream& ostr, const JSONBase& j) { return j.print(ostr), ostr; }
-    std::istream& operator>>(std::istream& istr, JSONBase& j) { return j.scan(istr), istr; }
-    bool operator==(const JSONBase& a, const JSONBase& b) {
-        if (a.m_type != b.m_type)
-            return false;
-        using val_t = JSONBase::val_t;
-        switch (a.m_type) {
-        case val_t::float_t: return std::abs(a.d - b.d) < 1e-10;
-        case val_t::int_t: return a.i == b.i;
-        case val_t::bool_t: return a.b == b.b;
-        case val_t::string_t: return a.str == b.str;
-        case val_t::object_t:
-            if (a.obj.size() != b.obj.size())
-                return false;
-            for (auto ai = a.obj.begin(), bi = b.obj.begin(); ai != a.obj.end(); ai++, bi++)
-                if (ai->first != bi->first || *ai->second != *bi->second)
-                    return false;
-            return true;
-        case val_t::array_t:
-            if (a.arr.size() != b.arr.size())
-                return false;
-            for (size_t i = 0; i < a.arr.size(); i++)
-                if (*a.arr[i] != *b.arr[i])
-                    return false;
-            return true;
-        case val_t::null_t: return true;
-        default: break;
+
+    //containers and allocator used by BasicJSON. custom traits must provide same members:
+    //string_type and containers are constructible from allocator_type, object_type is std::map-like
+    //sorted container with heterogeneous lookup (find/lower_bound by std::string_view)
+    struct DefaultJSONTraits {
+        using allocator_type = std::allocator<char>;
+        using string_type = std::string;
+        template <typename T> using array_type = std::vector<T>;
+        template <typename K, typename V> using object_type = std::map<K, V, std::less<>>;
+    };
+    using JSONBase = BasicJSON<DefaultJSONTraits>;
+    using JSON = JSONBase;
+    //containers cache their compact text, to_string() regenerates only changed subtrees
+    //(each node also stores parent pointer, cached documents must not be printed from several threads at once)
+    struct CachedJSONTraits : DefaultJSONTraits {
+        static constexpr bool serialization_cache = true;
+    };
+    using CachedJSON = BasicJSON<CachedJSONTraits>;
+#ifdef JSON_HAS_PMR
+    //std::pmr containers. nodes, strings and containers are allocated from memory_resource passed to root
+    //(e.g. PmrJSON::try_parse(str, {}, &monotonic_resource))
+    struct PmrJSONTraits {
+        using allocator_type = std::pmr::polymorphic_allocator<char>;
+        using string_type = std::pmr::string;
+        template <typename T> using array_type = std::pmr::vector<T>;
+        template <typename K, typename V> using object_type = std::pmr::map<K, V, std::less<>>;
+    };
+    using PmrJSON = BasicJSON<PmrJSONTraits>;
+#endif//JSON_HAS_PMR
+
+    //read-only view of value inside TapeDocument. valid while document is alive
+    class TapeValue {
+        using tag = details::tape_tag;
+    public:
+        class const_iterator {//elements of array or object in document order
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = TapeValue;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = TapeValue;
+
+            [[nodiscard]] TapeValue operator*() const noexcept { return TapeValue(m_tape, m_strings, m_is_object ? m_i + 2 : m_i); }
+            [[nodiscard]] std::string_view key() const noexcept {//only for objects
+                JSON_ASSERT(m_is_object);
+                return TapeValue(m_tape, m_strings, m_i).string_at(m_i);
+            }
+            const_iterator& operator++() noexcept {
+                m_i = details::tape_next(m_tape, m_is_object ? m_i + 2 : m_i);
+                skip_hidden();
+                return *this;
+            }
+            const_iterator operator++(int) noexcept { auto t = *this; ++*this; return t; }
+            [[nodiscard]] friend bool operator==(const const_iterator& a, const const_iterator& b) noexcept { return a.m_i == b.m_i; }
+            [[nodiscard]] friend bool operator!=(const const_iterator& a, const const_iterator& b) noexcept { return a.m_i != b.m_i; }
+        private:
+            friend class TapeValue;
+            const_iterator(const uint64_t* tape, const char* strings, size_t i, bool is_object) noexcept
+                : m_tape(tape), m_strings(strings), m_i(i), m_is_object(is_object) { skip_hidden(); }
+            void skip_hidden() noexcept {//closing word stops the loop
+                while (m_is_object && details::tape_tag_of(m_tape[m_i]) == tag::hidden_key)
+                    m_i = details::tape_next(m_tape, m_i + 2);
+            }
+            const uint64_t* m_tape;
+            const char* m_strings;
+            size_t m_i;//key word for objects, value word for arrays
+            bool m_is_object;
+        };
+
+        [[nodiscard]] bool is_float() const noexcept { return type() == tag::double_value; }
+        [[nodiscard]] bool is_integer() const noexcept { return type() == tag::int64 || type() == tag::uint64; }
+        [[nodiscard]] bool is_boolean() const noexcept { return type() == tag::true_value || type() == tag::false_value; }
+        [[nodiscard]] bool is_string() const noexcept { return type() == tag::string; }
+        [[nodiscard]] bool is_object() const noexcept { return type() == tag::start_object; }
+        [[nodiscard]] bool is_array() const noexcept { return type() == tag::start_array; }
+        [[nodiscard]] bool is_null() const noexcept { return type() == tag::null_value; }
+        [[nodiscard]] bool is_number() const noexcept { return is_integer() || is_float(); }
+
+        //binary search in objects with more than 16 keys, linear in smaller ones. for duplicate keys last one wins (as in JSONBase)
+        [[nodiscard]] TapeValue operator[](std::string_view key) const {
+            size_t f = find_key(key);
+            JSON_ASSERT(f != npos); //must contains element
+            return TapeValue(m_tape, m_strings, f);
+        }
+        [[nodiscard]] TapeValue operator[](size_t i) const {//O(1) with element table, small arrays are walked
+            JSON_TYPE_ASSERT(is_array());
+            JSON_ASSERT(i < array_size());
+            if (size_t table = size_t(m_tape[m_i + 1])) return TapeValue(m_tape, m_strings, size_t(m_tape[table + i]));
+            size_t p = m_i + 2;
+            while (i--) p = details::tape_next(m_tape, p);
+            return TapeValue(m_tape, m_strings, p);
+        }
+        [[nodiscard]] bool contains(std::string_view key) const { return find_key(key) != npos; }
+
+        [[nodiscard]] size_t array_size() const {
+            JSON_TYPE_ASSERT(is_array());
+            return size_t(details::tape_payload(m_tape[details::tape_payload(m_tape[m_i])]));
+        }
+        [[nodiscard]] size_t object_size() const {
+            JSON_TYPE_ASSERT(is_object());
+            return size_t(details::tape_payload(m_tape[details::tape_payload(m_tape[m_i])]));
+        }
+        [[nodiscard]] bool empty() const {
+            JSON_TYPE_ASSERT(is_object() || is_array());
+            return details::tape_payload(m_tape[m_i]) == m_i + 2;
+        }
+
+        //same T as for JSONBase numbers: integers above int64_t range are unsigned or floating point
+        template <typename T, std::enable_if_t<std::is_floating_point_v<T>, bool> = true>
+        [[nodiscard]] double get() const {
+            JSON_TYPE_ASSERT(is_float() || type() == tag::uint64);
+            return is_float() ? double_value() : static_cast<double>(m_tape[m_i + 1]);
+        }
+        template <typename T, std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T>, bool> = true>
+        [[nodiscard]] int64_t get() const { JSON_TYPE_ASSERT(type() == tag::int64); return static_cast<int64_t>(m_tape[m_i + 1]); }
+        template <typename T, std::enable_if_t<std::is_unsigned_v<T> && !std::is_same_v<T, bool>, bool> = true>
+        [[nodiscard]] T get() const {
+            JSON_TYPE_ASSERT(type() == tag::uint64 || (type() == tag::int64 && static_cast<int64_t>(m_tape[m_i + 1]) >= 0));
+            JSON_TYPE_ASSERT(m_tape[m_i + 1] <= std::numeric_limits<T>::max());
+            return static_cast<T>(m_tape[m_i + 1]);
+        }
+        template <typename T, std::enable_if_t<std::is_same_v<T, bool>, bool> = true>
+        [[nodiscard]] bool get() const { JSON_TYPE_ASSERT(is_boolean()); return type() == tag::true_value; }
+        template <typename T, std::enable_if_t<std::is_same_v<T, std::string_view> || std::is_same_v<T, std::string>, bool> = true>
+        [[nodiscard]] T get() const { JSON_TYPE_ASSERT(is_string()); return T(string_at(m_i)); }
+        template <typename T, std::enable_if_t<std::is_same_v<T, std::nullptr_t>, bool> = true>
+        [[nodiscard]] std::nullptr_t get() const { JSON_TYPE_ASSERT(is_null()); return nullptr; }
+
+        [[nodiscard]] const_iterator begin() const {
+            JSON_TYPE_ASSERT(is_object() || is_array());
+            return const_iterator(m_tape, m_strings, m_i + 2, is_object());
+        }
+        [[nodiscard]] const_iterator end() const {
+            JSON_TYPE_ASSERT(is_object() || is_array());
+            return const_iterator(m_tape, m_strings, size_t(details::tape_payload(m_tape[m_i])), is_object());
+        }
+
+        //mutable copy, object keys are sorted. numbers above int64_t range become raw numbers
+        template <typename JSON_ = JSONBase>
+        [[nodiscard]] JSON_ to_json(const typename JSON_::allocator_type& alloc = typename JSON_::allocator_type()) const {
+            JSON_ j(alloc);
+            fill(j);
+            return j;
+        }
+        explicit operator JSONBase() const { return to_json(); }
+
+        //same format as JSONBase::to_string, but object keys are printed in document order
+        [[nodiscard]] std::string to_string(int tab_size = -1) const {
+            std::ostringstream s;
+            print(s, tab_size);
+            return std::move(s).str();
         }
-        return false;
+        void print(std::ostream& ostr, int tab_size = -1, size_t space_offset = 0) const {
+            auto offset = std::string(space_offset, ' ');
+            auto delta = tab_size < 0 ? std::string() : std::string(tab_size, ' ');
+            auto newline = tab_size < 0 ? std::string() : std::string(1, '\n');
+            auto space = tab_size < 0 ? std::string() : std::string(1, ' ');
+            switch (type()) {
+            case tag::string: ostr << ('"' + details::escape_sec_to_string(string_at(m_i)) + '"'); break;
+            case tag::start_object: case tag::start_array: {
+                char open = is_object() ? '{' : '[', close = is_object() ? '}' : ']';
+                if (empty()) {
+                    ostr << open << close;
+                    break;
+                }
+                ostr << open << newline;
+                for (auto it = begin(), last = end(); it != last;) {
+                    ostr << offset << delta;
+                    if (is_object()) ostr << '"' << details::escape_sec_to_string(it.key()) << '"' << ':' << space;
+                    (*it).print(ostr, tab_size, space_offset + (tab_size > 0 ? tab_size : 0));
+                    (++it != last ? ostr << ',' << newline : ostr << newline << offset << close);
+                }
+                break;
+            }
+            case tag::double_value: details::print_double(ostr, double_value()); break;
+            case tag::int64: ostr << static_cast<int64_t>(m_tape[m_i + 1]); break;
+            case tag::uint64: ostr << m_tape[m_i + 1]; break;
+            case tag::true_value: ostr << "true"; break;
+            case tag::false_value: ostr << "false"; break;
+            case tag::null_value: ostr << "null"; break;
+            default: break;
+            }
+        }
+        friend std::ostream& operator<<(std::ostream& out, const TapeValue& v) {
+            v.print(out);
+            return out;
+        }
+
+    protected:
+        static constexpr size_t npos = size_t(-1);
+        TapeValue(const uint64_t* tape, const char* strings, size_t i) noexcept : m_tape(tape), m_strings(strings), m_i(i) {}
+
+        [[nodiscard]] tag type() const noexcept { return details::tape_tag_of(m_tape[m_i]); }
+        [[nodiscard]] std::string_view string_at(size_t i) const noexcept {
+            return std::string_view(m_strings + details::tape_payload(m_tape[i]), size_t(m_tape[i + 1]));
+        }
+        [[nodiscard]] double double_value() const noexcept {
+            double d;
+            std::memcpy(&d, &m_tape[m_i + 1], sizeof(d));
+            return d;
+        }
+        [[nodiscard]] size_t find_key(std::string_view key) const {//index of value or npos
+            JSON_TYPE_ASSERT(is_object());
+            if (size_t table = size_t(m_tape[m_i + 1])) {
+                const uint64_t* first = m_tape + table;
+                const uint64_t* last = first + object_size();
+                auto f = std::lower_bound(first, last, key, [this](uint64_t p, std::string_view k) { return string_at(size_t(p)) < k; });
+                return f != last && string_at(size_t(*f)) == key ? size_t(*f) + 2 : npos;
+            }
+            for (size_t p = m_i + 2, last = size_t(details::tape_payload(m_tape[m_i])); p != last; p = details::tape_next(m_tape, p + 2))
+                if (details::tape_tag_of(m_tape[p]) == tag::string && string_at(p) == key) return p + 2;
+            return npos;
+        }
+        template <typename JSON_>
+        void fill(JSON_& j) const {
+            switch (type()) {
+            case tag::string: j = JSON_(string_at(m_i), j.get_allocator()); break;
+            case tag::double_value: j = double_value(); break;
+            case tag::int64: j = static_cast<int64_t>(m_tape[m_i + 1]); break;
+            case tag::uint64: {//out of int64_t range, kept exact as raw number
+                char buf[24];
+                auto res = std::to_chars(buf, buf + sizeof(buf), m_tape[m_i + 1]);
+                j.set_number(std::string_view(buf, size_t(res.ptr - buf)), true);
+                break;
+            }
+            case tag::true_value: j = true; break;
+            case tag::false_value: j = false; break;
+            case tag::start_array:
+                j.set_type_to(JSON_::val_t::array_t);
+                j.reserve(array_size());
+                for (auto v : *this) v.fill(j.emplace_back());
+                break;
+            case tag::start_object:
+                j.set_type_to(JSON_::val_t::object_t);
+                for (auto it = begin(), last = end(); it != last; ++it)
+                    (*it).fill(j[it.key()]);
+                break;
+            default: break;
+            }
+        }
+
+        const uint64_t* m_tape;
+        const char* m_strings;
+        size_t m_i;//index of value word
+    };
+
+    //immutable document parsed into flat tape of 64 bit words and one string buffer (no per value allocations).
+    //document is also view of its root value
+    class TapeDocument : public TapeValue {
+    public:
+        TapeDocument() noexcept : TapeValue(nullptr, nullptr, 0) { bind(); }//null
+        TapeDocument(const TapeDocument&) = delete;
+        TapeDocument& operator=(const TapeDocument&) = delete;
+        TapeDocument(TapeDocument&& v) noexcept : TapeValue(nullptr, nullptr, 0), m_words(std::move(v.m_words)), m_chars(std::move(v.m_chars)) {
+            bind();
+            v.clear();
+        }
+        TapeDocument& operator=(TapeDocument&& v) noexcept {
+            m_words = std::move(v.m_words);
+            m_chars = std::move(v.m_chars);
+            bind();
+            v.clear();
+            return *this;
+        }
+
+        //lazy_numbers option is ignored, numbers are always converted
+        [[nodiscard]] static parse_result<TapeDocument> try_parse(std::string_view str, const parse_options& opts = {}) {
+            TapeDocument doc;
+            doc.m_words.reserve(str.size() / 8 + 2);//about one value per 8 bytes of input
+            details::tape_builder b(doc.m_words, doc.m_chars);
+            details::parser<details::tape_builder> p(str, opts);
+            if (json_errc e = p.parse(b); e != json_errc::none)
+                return details::make_parse_error(str, e, p.offset());
+            doc.m_words.shrink_to_fit();//document is never extended
+            doc.m_chars.shrink_to_fit();
+            doc.bind();
+            return doc;
+        }
+        [[nodiscard]] static TapeDocument from_string(std::string_view str, bool enable_comments = false) {
+            auto r = try_parse(str, parse_options{ enable_comments });
+            if (!r) JSON_PARSE_ERROR(r.error().message());
+            return std::move(r).value();
+        }
+
+        [[nodiscard]] size_t tape_size() const noexcept { return m_words.size(); }//in 64 bit words
+        [[nodiscard]] size_t memory_usage() const noexcept { return m_words.capacity() * sizeof(uint64_t) + m_chars.capacity(); }
+
+    private:
+        static constexpr uint64_t null_tape[1] = { details::tape_word(details::tape_tag::null_value) };
+
+        void bind() noexcept {//empty document (default or moved from) is null
+            m_tape = m_words.empty() ? null_tape : m_words.data();
+            m_strings = m_chars.data();
+            m_i = 0;
+        }
+        void clear() noexcept {//leaves moved from document empty without allocation
+            m_words.clear();
+            m_chars.clear();
+            bind();
+        }
+
+        std::vector<uint64_t> m_words;
+        std::string m_chars;//all strings and keys without separators
+    };
+
+    //parser for input which arrives in parts (sockets, pipes). parts don't have to end at token boundaries:
+    //unfinished token is kept and its scanning continues with next part. Handler has details::parser interface
+    template <typename Handler>
+    class chunked_parser {
+    public:
+        explicit chunked_parser(Handler& h, const parse_options& opts = {}) : m_handler(h), m_parser({}, opts) {}
+        chunked_parser(const chunked_parser&) = delete;
+        chunked_parser& operator=(const chunked_parser&) = delete;
+
+        //parse next part of input. after error same error is returned
+        json_errc feed(std::string_view chunk) {
+            if (m_error.code != json_errc::none || m_finished) return m_error.code;
+            std::string_view buf = chunk;
+            if (!m_carry.empty()) {
+                m_carry.append(chunk.data(), chunk.size());
+                buf = m_carry;
+            }
+            m_parser.input(buf);
+            json_errc e = m_parser.resume(m_handler, false);
+            size_t used = m_parser.offset();
+            if (e != json_errc::none && !m_parser.incomplete()) return fail(e, buf, used);
+            advance(buf.substr(0, used));
+            if (m_carry.empty()) m_carry.assign(buf.data() + used, buf.size() - used);
+            else m_carry.erase(0, used);
+            return json_errc::none;
+        }
+        //end of input
+        json_errc finish() {
+            if (m_error.code != json_errc::none || m_finished) return m_error.code;
+            m_finished = true;
+            m_parser.input(m_carry);
+            if (json_errc e = m_parser.resume(m_handler, true); e != json_errc::none) return fail(e, m_carry, m_parser.offset());
+            std::string().swap(m_carry);
+            return json_errc::none;
+        }
+        [[nodiscard]] const parse_error& error() const noexcept { return m_error; }//offset, line and column from input start
+        [[nodiscard]] bool complete() const noexcept { return m_parser.complete(); }//root value is parsed (only spaces can follow)
+    private:
+        json_errc fail(json_errc e, std::string_view buf, size_t offset) noexcept {
+            advance(buf.substr(0, offset));
+            return m_error.code = e;
+        }
+        void advance(std::string_view s) noexcept {//move error position over parsed input
+            m_error.offset += s.size();
+            size_t nl = s.rfind('\n');
+            if (nl == std::string_view::npos) m_error.column += s.size();
+            else {
+                m_error.line += size_t(std::count(s.begin(), s.end(), '\n'));
+                m_error.column = s.size() - nl;
+            }
+        }
+
+        Handler& m_handler;
+        details::parser<Handler> m_parser;
+        std::string m_carry;//unparsed tail of input
+        parse_error m_error;
+        bool m_finished = false;
+    };
+
+    //chunked_parser which builds JSON_ (same result as JSON_::try_parse of whole input)
+    template <typename JSON_ = JSONBase>
+    class stream_parser {
+    public:
+        explicit stream_parser(const parse_options& opts = {}, const typename JSON_::allocator_type& alloc = typename JSON_::allocator_type())
+            : m_root(alloc), m_builder(m_root, opts.lazy_numbers), m_parser(m_builder, opts) {}
+
+        json_errc feed(std::string_view chunk) { return m_parser.feed(chunk); }
+        [[nodiscard]] parse_result<JSON_> finish() {
+            if (m_parser.finish() != json_errc::none) return m_parser.error();
+            return std::move(m_root);
+        }
+        [[nodiscard]] bool complete() const noexcept { return m_parser.complete(); }
+    private:
+        JSON_ m_root;
+        details::dom_builder<JSON_> m_builder;
+        chunked_parser<details::dom_builder<JSON_>> m_parser;
+    };
+
+    //document which is read by many threads and replaced as whole (hot-reloaded configuration).
+    //published versions are immutable, old version is released when last snapshot of it is dropped.
+    //readers use reader::get() (one atomic load while version is unchanged) or snapshot(), neither of them locks:
+    //current version is kept in one of two slots, readers pin slot with counter and publish() fills other slot
+    //after its readers left. publishers are serialized and may wait for readers which are copying snapshot.
+    //CachedJSON can't be used here: to_string() writes cache
+    template <typename JSON_ = JSONBase>
+    class BasicSharedDocument {
+    public:
+        using snapshot_type = std::shared_ptr<const JSON_>;
+
+        BasicSharedDocument() : m_slots{ std::make_shared<const JSON_>() } {}
+        explicit BasicSharedDocument(JSON_ doc) : m_slots{ std::make_shared<const JSON_>(std::move(doc)) } {}
+        BasicSharedDocument(const BasicSharedDocument&) = delete;
+        BasicSharedDocument& operator=(const BasicSharedDocument&) = delete;
+
+        [[nodiscard]] snapshot_type snapshot() const {//current version, valid after next publish
+            for (;;) {//repeated only if publish() switched slots meanwhile
+                unsigned i = m_current.load();
+                m_readers[i].fetch_add(1);
+                if (m_current.load() == i) {
+                    snapshot_type doc = m_slots[i];
+                    m_readers[i].fetch_sub(1);
+                    return doc;
+                }
+                m_readers[i].fetch_sub(1);
+            }
+        }
+        void publish(JSON_ doc) { publish(std::make_shared<const JSON_>(std::move(doc))); }
+        void publish(snapshot_type doc) {
+            JSON_ASSERT(doc != nullptr);
+            std::lock_guard<std::mutex> lock(m_publish_mutex);
+            unsigned old = m_current.load(std::memory_order_relaxed), next = old ^ 1;
+            wait_readers(next);//late readers which found `next` current before last publish
+            m_slots[next] = std::move(doc);
+            m_current.store(next);
+            m_version.store(m_version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            wait_readers(old);
+            snapshot_type released = std::move(m_slots[old]);
+        }//old version is released here if nobody reads it
+        //copy current version, modify copy with f(JSON_&) and publish it. updates are serialized
+        template <typename F>
+        void update(F&& f) {
+            std::lock_guard<std::mutex> lock(m_update_mutex);
+            JSON_ doc(*snapshot());
+            std::forward<F>(f)(doc);
+            publish(std::move(doc));
+        }
+        [[nodiscard]] uint64_t version() const noexcept { return m_version.load(std::memory_order_acquire); }
+
+        //per thread handle. keeps snapshot and takes new one only after publish, so reading doesn't touch shared counters
+        class reader {
+        public:
+            explicit reader(const BasicSharedDocument& d) : m_src(&d) { refresh(); }
+            [[nodiscard]] const JSON_& get() {
+                if (m_version != m_src->version()) refresh();
+                return *m_doc;
+            }
+            [[nodiscard]] const snapshot_type& snapshot() { (void)get(); return m_doc; }
+            void release() noexcept { m_doc.reset(); m_version = uint64_t(-1); }//don't keep old version alive while idle
+        private:
+            void refresh() {
+                m_version = m_src->version();//before snapshot: document is never older than version
+                m_doc = m_src->snapshot();
+            }
+            const BasicSharedDocument* m_src;
+            snapshot_type m_doc;
+            uint64_t m_version = 0;
+        };
+        [[nodiscard]] reader make_reader() const { return reader(*this); }
+
+    private:
+        void wait_readers(unsigned slot) const noexcept {//readers hold slot only while copying shared_ptr
+            while (m_readers[slot].load() != 0) std::this_thread::yield();
+        }
+
+        snapshot_type m_slots[2];//m_slots[m_current] is current version, other slot is empty
+        std::atomic<unsigned> m_current{ 0 };
+        mutable std::atomic<size_t> m_readers[2] = {};//threads which are reading slot
+        std::mutex m_publish_mutex;
+        std::mutex m_update_mutex;
+        std::atomic<uint64_t> m_version{ 0 };
+    };
+    using SharedDocument = BasicSharedDocument<JSONBase>;
+
+#ifdef JSON_HAS_COROUTINES
+    //coroutine result. coroutine starts immediately, result is available when done() is true
+    //(poll from event loop) or it can be co_await-ed by other coroutine
+    template <typename T>
+    class parse_task {
+    public:
+        struct promise_type;
+        using handle = std::coroutine_handle<promise_type>;
+        struct promise_type {
+            std::optional<T> value;
+            std::exception_ptr error;
+            std::coroutine_handle<> continuation;
+
+            parse_task get_return_object() noexcept { return parse_task(handle::from_promise(*this)); }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            auto final_suspend() noexcept {
+                struct final_awaiter {
+                    bool await_ready() noexcept { return false; }
+                    std::coroutine_handle<> await_suspend(handle h) noexcept {
+                        auto c = h.promise().continuation;
+                        return c ? c : std::noop_coroutine();
+                    }
+                    void await_resume() noexcept {}
+                };
+                return final_awaiter{};
+            }
+            void return_value(T v) { value.emplace(std::move(v)); }
+            void unhandled_exception() noexcept { error = std::current_exception(); }
+        };
+
+        parse_task(parse_task&& o) noexcept : m_h(std::exchange(o.m_h, {})) {}
+        parse_task& operator=(parse_task&& o) noexcept {
+            if (this != &o) {
+                if (m_h) m_h.destroy();
+                m_h = std::exchange(o.m_h, {});
+            }
+            return *this;
+        }
+        ~parse_task() { if (m_h) m_h.destroy(); }//suspended coroutine is destroyed too (source must not resume it later)
+
+        [[nodiscard]] bool done() const noexcept { return m_h && m_h.done(); }
+        [[nodiscard]] T get() {//rethrows exception from coroutine (e.g. read error)
+            JSON_ASSERT(done());
+            if (m_h.promise().error) std::rethrow_exception(m_h.promise().error);
+            return std::move(*m_h.promise().value);
+        }
+        auto operator co_await() noexcept {
+            struct awaiter {
+                parse_task& task;
+                bool await_ready() const noexcept { return task.done(); }
+                void await_suspend(std::coroutine_handle<> h) noexcept { task.m_h.promise().continuation = h; }
+                T await_resume() { return task.get(); }
+            };
+            return awaiter{ *this };
+        }
+    private:
+        explicit parse_task(handle h) noexcept : m_h(h) {}
+        handle m_h;
+    };
+
+    //parse document from async byte source. src.read_some(buf, size) returns awaitable with ptrdiff_t result:
+    //bytes read, 0 at end of input or negative if nothing is available yet (read is repeated).
+    //input is parsed by chunks, only unfinished token is kept between reads
+    template <typename JSON_ = JSONBase, typename Source>
+    parse_task<parse_result<JSON_>> async_parse(Source& src, parse_options opts = {},
+        typename JSON_::allocator_type alloc = typename JSON_::allocator_type(), size_t chunk_size = 64 * 1024) {
+        stream_parser<JSON_> p(opts, alloc);
+        std::unique_ptr<char[]> buf(new char[chunk_size]);
+        for (;;) {
+            ptrdiff_t n = co_await src.read_some(buf.get(), chunk_size);
+            if (n < 0) continue;
+            if (n == 0 || p.feed(std::string_view(buf.get(), size_t(n))) != json_errc::none) break;
+        }
+        co_return p.finish();
     }
-    bool operator!=(const JSONBase& a, const JSONBase& b) { return !(a == b); }
-    using JSON = JSONBase;
+
+#ifdef JSON_HAS_POSIX_FD
+    //non-blocking file descriptor (socket, pipe) as async_parse source. when read would block coroutine is suspended
+    //and wait_readable(fd, handle) is called, event loop must resume handle once fd is readable (e.g. epoll)
+    class fd_source {
+    public:
+        using wait_function = std::function<void(int, std::coroutine_handle<>)>;
+        fd_source(int fd, wait_function wait_readable) : m_fd(fd), m_wait(std::move(wait_readable)) {}
+
+        [[nodiscard]] auto read_some(char* buf, size_t size) noexcept {
+            struct awaiter {
+                fd_source& src;
+                char* buf;
+                size_t size;
+                ptrdiff_t result = -1;
+                bool await_ready() { return (result = src.try_read(buf, size)) >= 0; }
+                void await_suspend(std::coroutine_handle<> h) { src.m_wait(src.m_fd, h); }
+                ptrdiff_t await_resume() const noexcept { return result; }//-1 after wait, read is repeated
+            };
+            return awaiter{ *this, buf, size };
+        }
+    private:
+        ptrdiff_t try_read(char* buf, size_t size) {
+            for (;;) {
+                auto n = ::read(m_fd, buf, size);
+                if (n >= 0) return ptrdiff_t(n);
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return -1;
+                throw std::system_error(errno, std::generic_category(), "json: read");
+            }
+        }
+
+        int m_fd;
+        wait_function m_wait;
+    };
+#endif//JSON_HAS_POSIX_FD
+#endif//JSON_HAS_COROUTINES
 }//namespace CompactJSON
 
 #endif//JSON_H_INCLUDE_HEADER_
\ No newline at end of file
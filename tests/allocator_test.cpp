@@ -0,0 +1,65 @@
+//allocation failures in bounded arena: bad_alloc must leave documents destructible (no null nodes in containers).
+//compact(alloc) moves document to other arena
+//build: g++ -std=c++17 -I.. allocator_test.cpp -o allocator_test && ./allocator_test
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../json.hpp"
+using CompactJSON::PmrJSON;
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cout << __FILE__ << ":" << __LINE__ << ": " #cond "\n"; ++failures; } } while (false)
+
+//runs f(resource) with arenas of growing size, counts runs which ran out of memory
+template <typename F>
+int with_arenas(F f) {
+    int out_of_memory = 0;
+    for (size_t size : { 256, 1024, 4096, 8192, 65536 }) {
+        std::vector<char> buf(size);
+        std::pmr::monotonic_buffer_resource arena(buf.data(), size, std::pmr::null_memory_resource());
+        try { f(&arena); }
+        catch (const std::bad_alloc&) { out_of_memory++; }
+    }
+    return out_of_memory;
+}
+
+void test_compact(const std::string& text) {
+    auto old_arena = std::make_unique<std::pmr::monotonic_buffer_resource>();
+    std::pmr::monotonic_buffer_resource fresh;
+    PmrJSON doc = PmrJSON::try_parse(text, {}, old_arena.get()).value();
+    doc.compact(&fresh);
+    old_arena.reset();//nothing refers to it
+    CHECK(doc.get_allocator().resource() == &fresh && doc[5].get_allocator().resource() == &fresh);
+    CHECK(doc.to_string() == PmrJSON::try_parse(text).value().to_string());
+}
+
+int main() {
+    std::string strings = "[";
+    for (int i = 0; i < 2000; i++) strings += (i ? ",\"" : "\"") + std::string(40, 'a' + i % 26) + '"';
+    strings += "]";
+    CHECK(with_arenas([&](std::pmr::memory_resource* r) { (void)PmrJSON::try_parse(strings, {}, r); }) > 0);
+    CHECK(with_arenas([&](std::pmr::memory_resource* r) { PmrJSON j(r); j.resize(3000); }) > 0);
+    CHECK(with_arenas([&](std::pmr::memory_resource* r) {
+        PmrJSON j(r);
+        for (int i = 0; i < 1000; i++) (void)j["key " + std::to_string(i) + std::string(30, 'k')];
+    }) > 0);
+    PmrJSON source = PmrJSON::try_parse(strings).value();
+    source.resize(3000);
+    CHECK(with_arenas([&](std::pmr::memory_resource* r) { PmrJSON j(r); j = source; }) > 0);
+    CHECK(with_arenas([&](std::pmr::memory_resource* r) {
+        PmrJSON j(r);
+        for (int i = 0; i < 1000; i++) j.emplace_back(std::string(64, 'x'));
+    }) > 0);
+    CHECK(with_arenas([&](std::pmr::memory_resource* r) {
+        PmrJSON j(r);
+        for (int i = 0; i < 1000; i++) j.emplace("key " + std::to_string(i), std::string(64, 'x'));
+    }) > 0);
+    CHECK(with_arenas([&](std::pmr::memory_resource* r) {
+        PmrJSON j(r);
+        for (int i = 0; i < 300; i++) j.emplace_back(source[i % 2000]);
+    }) > 0);
+    test_compact(strings);
+    std::cout << (failures ? "FAILED\n" : "ok\n");
+    return failures ? 1 : 0;
+}
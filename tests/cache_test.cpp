@@ -0,0 +1,96 @@
+//randomized check of CachedJSON serialization cache: same mutations are applied to CachedJSON and JSON,
+//printed text must match after each step (every ancestor of changed node must be dirty).
+//build: g++ -std=c++17 -I.. cache_test.cpp -o cache_test && ./cache_test [seed] [steps]
+#include <iostream>
+#include <random>
+#include <string>
+#include "../json.hpp"
+using CompactJSON::JSON;
+using CompactJSON::CachedJSON;
+
+template <typename J>
+J random_value(std::mt19937& rng, int depth) {
+    switch (rng() % (depth > 0 ? 7 : 5)) {
+    case 0: return nullptr;
+    case 1: return static_cast<int64_t>(rng() % 1000) - 500;
+    case 2: return (rng() % 1000) / 8.0;
+    case 3: return rng() % 2 == 0;
+    case 4: return "s" + std::to_string(rng() % 100);
+    case 5: {
+        J a;
+        a.reserve(4);//empty array
+        for (size_t n = rng() % 4; n > 0; n--) a.push_back(random_value<J>(rng, depth - 1));
+        return a;
+    }
+    default: {
+        J o = std::initializer_list<J>{};//empty object
+        for (size_t n = rng() % 4; n > 0; n--) o["k" + std::to_string(rng() % 6)] = random_value<J>(rng, depth - 1);
+        return o;
+    }
+    }
+}
+
+//walks from root to random node, both documents have same shape so same rng state gives same path
+template <typename J>
+J& random_node(J& root, std::mt19937 rng) {
+    J* v = &root;
+    while (rng() % 4 != 0) {
+        if (v->is_array() && v->array_size() > 0) v = &(*v)[rng() % v->array_size()];
+        else if (v->is_object() && v->object_size() > 0) {
+            auto it = v->begin();
+            std::advance(it, rng() % v->object_size());
+            v = &*it;
+        }
+        else break;
+    }
+    return *v;
+}
+
+template <typename J>
+void mutate(J& root, std::mt19937 path, std::mt19937 rng) {
+    J& v = random_node(root, path);
+    switch (rng() % 8) {
+    case 0: v = random_value<J>(rng, 3); break;
+    case 1: if (v.is_array()) v.push_back(random_value<J>(rng, 2)); break;
+    case 2: if (v.is_array()) v.resize(rng() % 3); break;
+    case 3: if (v.is_object()) v["k" + std::to_string(rng() % 6)] = random_value<J>(rng, 2); break;
+    case 4: {
+        std::string key = "k" + std::to_string(rng() % 6);
+        if (v.is_object() && v.contains(key)) v.erase(key);
+        break;
+    }
+    case 5: if (v.is_string()) { v.template get<std::string>() += "!"; v.invalidate_cache(); } break;
+    case 6: if (v.is_boolean()) v.template get<bool>() = !v.template get<bool>(); break;
+    default: {//subtree copied from another place of same document
+        J copy = random_node(root, rng);
+        v = std::move(copy);
+    }
+    }
+}
+
+int main(int argc, char** argv) {
+    unsigned seed = argc > 1 ? std::stoul(argv[1]) : 1;
+    int steps = argc > 2 ? std::stoi(argv[2]) : 20000;
+    std::mt19937 gen_a(seed), gen_b(seed);
+    JSON plain = random_value<JSON>(gen_a, 5);
+    CachedJSON cached = random_value<CachedJSON>(gen_b, 5);
+    std::mt19937 rng(seed);
+    for (int step = 0; step < steps; step++) {
+        if (step % 50 == 0) {//keep documents from growing without limit
+            std::mt19937 r(rng()), r2 = r;
+            plain = random_value<JSON>(r, 5);
+            cached = random_value<CachedJSON>(r2, 5);
+        }
+        std::mt19937 path(rng()), op(rng());
+        mutate(plain, path, op);
+        mutate(cached, path, op);
+        if (rng() % 3 == 0) (void)random_node(cached, path).to_string();//fill caches of inner nodes only
+        std::string expected = plain.to_string(), actual = cached.to_string();
+        if (expected != actual) {
+            std::cout << "seed " << seed << " step " << step << ":\n" << expected << "\n" << actual << "\n";
+            return 1;
+        }
+    }
+    std::cout << "ok\n";
+    return 0;
+}
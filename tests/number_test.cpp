@@ -0,0 +1,80 @@
+//number access checks: get<T>() accepts same T for eager, lazy (raw) and tape numbers, const and non-const,
+//reading keeps raw text, writes through returned references are printed.
+//build: g++ -std=c++17 -I.. number_test.cpp -o number_test && ./number_test
+#include <iostream>
+#include <string>
+#include <utility>
+#include "../json.hpp"
+using namespace CompactJSON;
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cout << __FILE__ << ":" << __LINE__ << ": " #cond "\n"; ++failures; } } while (false)
+
+template <typename F>
+bool accepts(F f) {
+    try { f(); }
+    catch (const std::exception&) { return false; }
+    return true;
+}
+//one letter per accepted type
+template <typename V>
+std::string accepted(V&& v) {
+    std::string r;
+    r += accepts([&] { (void)v.template get<double>(); }) ? "d" : "-";
+    r += accepts([&] { (void)v.template get<int64_t>(); }) ? "i" : "-";
+    r += accepts([&] { (void)v.template get<unsigned long long>(); }) ? "u" : "-";
+    r += accepts([&] { (void)v.template get<uint32_t>(); }) ? "3" : "-";
+    r += accepts([&] { (void)v.template get<uint8_t>(); }) ? "8" : "-";
+    return r;
+}
+
+const std::string numbers = "[5,-3,2.5,1.50,18446744073709551615,1234567890123456789012345,9223372036854775807]";
+const char* expected[] = { "-iu38", "-i---", "d----", "d----", "d-u--", "d----", "-iu--" };
+
+void test_accepted_types() {
+    parse_options lazy;
+    lazy.lazy_numbers = true;
+    JSON eager = JSON::from_string(numbers), raw = JSON::try_parse(numbers, lazy).value();
+    TapeDocument tape = TapeDocument::from_string(numbers);
+    for (size_t k = 0; k < eager.array_size(); k++) {
+        std::string want = expected[k];
+        CHECK(accepted(std::as_const(eager)[k]) == want);
+        CHECK(accepted(eager[k]) == want);
+        CHECK(accepted(std::as_const(raw)[k]) == want);
+        CHECK(accepted(raw[k]) == want);
+        CHECK(accepted(tape[k]) == want);
+    }
+    CHECK(raw[4].get<uint64_t>() == 18446744073709551615ull && eager[4].get<uint64_t>() == 18446744073709551615ull);
+    CHECK(JSON(uint64_t(18446744073709551615ull)).get<uint64_t>() == 18446744073709551615ull);
+    CHECK(raw.to_string() == numbers);//reads kept text
+    CHECK(raw == eager);
+}
+
+void test_references() {
+    parse_options lazy;
+    lazy.lazy_numbers = true;
+    JSON eager = JSON::from_string("[1,2.5,1.50]"), raw = JSON::try_parse("[1,2.5,1.50]", lazy).value();
+    for (JSON* j : { &eager, &raw }) {
+        int64_t& i = (*j)[0].get<int64_t>();
+        double& d = (*j)[1].get<double>();
+        (void)(*j)[2].get<double>();
+        i += 1;
+        d = 0.25;
+    }
+    CHECK(eager.to_string() == "[2,0.25,1.5]");
+    CHECK(raw.to_string() == "[2,0.25,1.50]");
+    CHECK(raw == eager && raw[0].get<uint8_t>() == 2);
+    JSON copy = raw;
+    CHECK(copy.to_string() == raw.to_string());
+    CachedJSON cached = CachedJSON::try_parse("{\"a\":[1,2.5]}", lazy).value();
+    std::string before = cached.to_string();
+    cached["a"][1].get<double>() = 3;
+    CHECK(before == "{\"a\":[1,2.5]}" && cached.to_string() == "{\"a\":[1,3]}");
+}
+
+int main() {
+    test_accepted_types();
+    test_references();
+    std::cout << (failures ? "FAILED\n" : "ok\n");
+    return failures ? 1 : 0;
+}
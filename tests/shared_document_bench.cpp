@@ -0,0 +1,86 @@
+//SharedDocument contention benchmark: 1-64 reader threads take snapshots while writer publishes every millisecond.
+//mutex_document (previous design: shared_ptr guarded by mutex) is measured with same load for comparison.
+//build: g++ -std=c++17 -O2 -pthread -I.. shared_document_bench.cpp -o shared_document_bench && ./shared_document_bench [ms]
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../json.hpp"
+using CompactJSON::JSON;
+using CompactJSON::SharedDocument;
+using clk = std::chrono::steady_clock;
+
+class mutex_document {
+public:
+    explicit mutex_document(JSON doc) : m_doc(std::make_shared<const JSON>(std::move(doc))) {}
+    std::shared_ptr<const JSON> snapshot() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_doc;
+    }
+    void publish(JSON doc) {
+        auto p = std::make_shared<const JSON>(std::move(doc));
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_doc.swap(p);
+    }
+private:
+    mutable std::mutex m_mutex;
+    std::shared_ptr<const JSON> m_doc;
+};
+
+JSON make_config(int64_t version) {
+    JSON j = JSON::from_string(R"({"limits":{"rps":100,"burst":20},"hosts":["a","b","c"]})");
+    j["version"] = version;
+    return j;
+}
+
+struct result {
+    double reads_per_ms;
+    double worst_us;//slowest snapshot() call
+};
+
+template <typename Doc>
+result run(Doc& doc, int readers, int ms) {
+    std::atomic<bool> stop{ false };
+    std::atomic<uint64_t> reads{ 0 };
+    std::atomic<int64_t> worst_ns{ 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < readers; t++)
+        threads.emplace_back([&] {
+            uint64_t n = 0;
+            int64_t worst = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto start = clk::now();
+                auto s = doc.snapshot();
+                worst = std::max<int64_t>(worst, std::chrono::duration_cast<std::chrono::nanoseconds>(clk::now() - start).count());
+                if ((*s)["limits"]["rps"].template get<int64_t>() != 100) std::abort();
+                n++;
+            }
+            reads += n;
+            for (int64_t w = worst_ns.load(); w < worst && !worst_ns.compare_exchange_weak(w, worst);) {}
+        });
+    std::thread writer([&] {
+        for (int64_t v = 1; !stop.load(); v++) {
+            doc.publish(make_config(v));
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    stop = true;
+    for (auto& t : threads) t.join();
+    writer.join();
+    return { double(reads) / ms, double(worst_ns) / 1000 };
+}
+
+int main(int argc, char** argv) {
+    int ms = argc > 1 ? std::stoi(argv[1]) : 300;
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << "\n";
+    std::cout << "readers  shared reads/ms  worst us  |  mutex reads/ms  worst us\n";
+    for (int readers : { 1, 2, 4, 8, 16, 32, 64 }) {
+        SharedDocument shared(make_config(0));
+        mutex_document locked(make_config(0));
+        result a = run(shared, readers, ms), b = run(locked, readers, ms);
+        std::cout << readers << "\t " << a.reads_per_ms << "\t " << a.worst_us << "\t |  " << b.reads_per_ms << "\t " << b.worst_us << "\n";
+    }
+}
@@ -0,0 +1,157 @@
+//chunked parsing checks: every split of input gives same value or error as try_parse of whole input (validate gives same error),
+//long tokens cut by chunk ends are scanned in linear time, async_parse reads socket driven by epoll (linux, C++20).
+//build: g++ -std=c++20 -O2 -I.. stream_test.cpp -o stream_test && ./stream_test
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../json.hpp"
+#if defined(JSON_HAS_COROUTINES) && defined(JSON_HAS_POSIX_FD) && defined(__linux__)
+#define STREAM_TEST_EPOLL
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#endif
+using namespace CompactJSON;
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cout << __FILE__ << ":" << __LINE__ << ": " #cond "\n"; ++failures; } } while (false)
+
+std::string describe(const JSON& j, const parse_error* e) {
+    if (!e) return j.to_string();
+    return std::string(e->what()) + " at " + std::to_string(e->offset) + " (" + std::to_string(e->line) + ":" + std::to_string(e->column) + ")";
+}
+
+//Handler = dom_builder with projection, so skipped values are cut by chunk ends too
+std::string parse_chunked(std::string_view s, size_t chunk, const parse_options& opts, const projection* proj) {
+    JSON root;
+    details::dom_builder<JSON> builder(root, false, proj);
+    chunked_parser<details::dom_builder<JSON>> p(builder, opts);
+    for (size_t i = 0; i < s.size(); i += chunk) p.feed(s.substr(i, chunk));
+    return p.finish() == json_errc::none ? describe(root, nullptr) : describe(root, &p.error());
+}
+std::string parse_whole(std::string_view s, const parse_options& opts, const projection* proj) {
+    auto r = proj ? JSON::try_parse(s, *proj, opts) : JSON::try_parse(s, opts);
+    return r ? describe(r.value(), nullptr) : describe(JSON(), &r.error());
+}
+
+void test_splits() {
+    std::vector<std::string> corpus = {
+        R"({"a":[1,2.5e-3,-0,true,false,null,"s\u00e9\"x\ud83d\ude00"],"bb":{"c":{}},"k\n":"v"})",
+        "  [ 1 , 2 ]  ", "\"h\xc3\xa9\xf0\x9f\x98\x80\"", "12", "-1.5E+10", "[1,/*c*/2]//x\n", "/*a*/[/**/1//q\n,2]/*e*/",
+        R"({"id":1,"junk":[1,{"q":"x\"]"},/*]*/[]],"user":{"name":"n","age":12345},"items":[{"id":5,"z":[1e5,"s"]},7]})",
+        "[1,2", "[1,]", "{\"a\" 1}", "{\"a\":}", "[tru]", "nul", "\"\\ud800\"", "\"\\ud800x\"", "\"\\q\"", "\"a\nb\"",
+        "\xc0", "\"\xe2\x82\"", "01", "1.", "1e", "-", "[1]x", "/", "/*", "[1,/x]", "", "   ", "[[[[]]]]", "{\"\":\"\"}",
+        "1e400", "-1e400", "[1e-400,0.0e999]", "{\"a\":[2e308]}", "1.7976931348623157e308", "0.01e310", "1" + std::string(400, '0')
+    };
+    std::mt19937 rng(1);
+    const std::string chars = "[]{}\",:0123456789.-+eE tfnul\\/*\n\xc3\xa9";
+    for (size_t i = 0, n = corpus.size(); i < 2000; i++) {//random edits of valid and invalid documents
+        std::string s = corpus[rng() % n];
+        for (size_t k = rng() % 3; k > 0 && !s.empty(); k--) {
+            size_t pos = rng() % s.size();
+            if (rng() % 2) s[pos] = chars[rng() % chars.size()];
+            else s.insert(pos, 1, chars[rng() % chars.size()]);
+        }
+        corpus.push_back(s);
+    }
+    projection proj{ "id", "user.name", "items.id" };
+    const projection* projections[] = { nullptr, &proj };
+    for (const auto& s : corpus)
+        for (bool comments : { false, true })
+            for (const projection* p : projections) {
+                parse_options opts;
+                opts.enable_comments = comments;
+                std::string expected = parse_whole(s, opts, p);
+                if (!p) {
+                    auto v = JSON::validate(s, comments);
+                    auto r = JSON::try_parse(s, opts);
+                    CHECK(v.error == (r ? json_errc::none : r.error().code) && (r || v.offset == r.error().offset));
+                }
+                for (size_t chunk : { 1, 2, 3, 5, 7, 64 }) {
+                    std::string actual = parse_chunked(s, chunk, opts, p);
+                    if (actual != expected) {
+                        std::cout << "chunk " << chunk << " of [" << s << "]:\n  " << expected << "\n  " << actual << "\n";
+                        ++failures;
+                    }
+                }
+            }
+}
+
+//time of parsing doc in 64K chunks. quadratic rescanning of carried token makes 4x input 16x slower
+double chunked_ms(const std::string& doc, const projection* proj = nullptr) {
+    parse_options opts;
+    opts.enable_comments = true;
+    auto start = std::chrono::steady_clock::now();
+    std::string r = parse_chunked(doc, 65536, opts, proj);
+    CHECK(r.find(" at ") == std::string::npos);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+void test_linear_time() {
+    projection proj{ "id" };
+    auto docs = [&](size_t n) {
+        return std::vector<std::pair<std::string, const projection*>>{
+            { '"' + std::string(n, 'a') + '"', nullptr },
+            { "[0." + std::string(n, '1') + ']', nullptr },
+            { "/*" + std::string(n, 'x') + "*/1", nullptr },
+            { "{\"x\":[\"" + std::string(n, 'a') + "\"],\"id\":1}", &proj },
+            { std::string(n, ' ') + "1", nullptr },
+        };
+    };
+    auto small = docs(size_t(2) << 20), large = docs(size_t(8) << 20);
+    for (size_t i = 0; i < small.size(); i++) {
+        double t2 = chunked_ms(small[i].first, small[i].second), t8 = chunked_ms(large[i].first, large[i].second);
+        std::cout << "document " << i << ": 2 MB " << t2 << " ms, 8 MB " << t8 << " ms\n";
+        CHECK(t8 < 8 * t2 + 50);
+    }
+}
+
+#ifdef STREAM_TEST_EPOLL
+//writer sends document in small pieces, event loop resumes parser when socket is readable
+void test_socket() {
+    std::string doc = R"({"a":[1,2.5e3,-0,true,null,"s\u00e9"],"long":")" + std::string(5000, 'z') + R"(","n":12345678901234})";
+    int sv[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    fcntl(sv[0], F_SETFL, O_NONBLOCK);
+    int ep = epoll_create1(0);
+    std::coroutine_handle<> waiting;
+    fd_source src(sv[0], [&](int fd, std::coroutine_handle<> h) {
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        ev.data.fd = fd;
+        if (epoll_ctl(ep, EPOLL_CTL_MOD, fd, &ev) < 0) epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+        waiting = h;
+    });
+    auto task = async_parse<JSON>(src, {}, {}, 16);
+    size_t sent = 0, resumed = 0;
+    while (!task.done()) {
+        if (sent < doc.size()) {
+            size_t n = std::min<size_t>(37, doc.size() - sent);
+            CHECK(write(sv[1], doc.data() + sent, n) == ssize_t(n));
+            if ((sent += n) == doc.size()) shutdown(sv[1], SHUT_WR);
+        }
+        epoll_event ev;
+        if (epoll_wait(ep, &ev, 1, 100) == 1) {
+            ++resumed;
+            std::exchange(waiting, nullptr).resume();
+        }
+    }
+    auto r = task.get();
+    CHECK(r && *r == JSON::from_string(doc));
+    CHECK(resumed > 0);
+    close(ep);
+    close(sv[0]);
+    close(sv[1]);
+}
+#endif
+
+int main() {
+    test_splits();
+    test_linear_time();
+#ifdef STREAM_TEST_EPOLL
+    test_socket();
+#endif
+    std::cout << (failures ? "FAILED\n" : "ok\n");
+    return failures ? 1 : 0;
+}
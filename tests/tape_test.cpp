@@ -0,0 +1,116 @@
+//TapeDocument checks: indexing, key lookup and iteration agree with JSON for small and wide containers
+//(with and without element tables, with duplicate keys), lookup time is compared with JSON.
+//build: g++ -std=c++17 -O2 -I.. tape_test.cpp -o tape_test && ./tape_test
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include "../json.hpp"
+using namespace CompactJSON;
+using clk = std::chrono::steady_clock;
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { std::cout << __FILE__ << ":" << __LINE__ << ": " #cond "\n"; ++failures; } } while (false)
+
+//compares every value reachable from t with j
+void compare(const TapeValue& t, const JSON& j) {
+    if (t.is_array()) {
+        CHECK(j.is_array() && t.array_size() == j.array_size());
+        if (!j.is_array() || t.array_size() != j.array_size()) return;
+        size_t i = 0;
+        for (auto v : t) {
+            CHECK(v.to_string() == t[i].to_string());
+            compare(t[i], j[i]);
+            i++;
+        }
+        CHECK(i == j.array_size());
+    }
+    else if (t.is_object()) {
+        CHECK(j.is_object() && t.object_size() == j.object_size());
+        if (!j.is_object() || t.object_size() != j.object_size()) return;
+        size_t n = 0;
+        for (auto it = t.begin(); it != t.end(); ++it, ++n) {
+            CHECK(j.contains(it.key()));
+            if (j.contains(it.key())) compare(t[it.key()], j[it.key()]);
+        }
+        CHECK(n == j.object_size());
+        for (auto [k, v] : j.items()) CHECK(t.contains(k));
+        CHECK(!t.contains("missing key"));
+    }
+    else CHECK(t.to_json() == j);
+}
+
+std::string random_value(std::mt19937& rng, int depth) {
+    switch (depth > 3 ? rng() % 3 : rng() % 5) {
+    case 0: return std::to_string(int(rng() % 1000) - 500);
+    case 1: return "\"s" + std::to_string(rng() % 100) + '"';
+    case 2: return rng() % 2 ? "true" : "null";
+    case 3: {
+        std::string s = "[";
+        for (size_t i = 0, n = rng() % 2 ? rng() % 40 : rng() % 4; i < n; i++)
+            s += (i ? "," : "") + random_value(rng, depth + 1);
+        return s + ']';
+    }
+    default: {
+        std::string s = "{";
+        for (size_t i = 0, n = rng() % 2 ? rng() % 40 : rng() % 4; i < n; i++)//keys repeat
+            s += (i ? ",\"k" : "\"k") + std::to_string(rng() % 30) + "\":" + random_value(rng, depth + 1);
+        return s + '}';
+    }
+    }
+}
+
+void test_random() {
+    std::mt19937 rng(1);
+    for (int i = 0; i < 500; i++) {
+        std::string s = random_value(rng, 0);
+        compare(TapeDocument::from_string(s), JSON::from_string(s));
+    }
+}
+
+void test_move() {
+    TapeDocument a = TapeDocument::from_string("[1,2,3]");
+    TapeDocument b(std::move(a));
+    CHECK(a.is_null() && a.tape_size() == 0 && b.array_size() == 3);
+    a = std::move(b);
+    CHECK(b.is_null() && a[2].get<int64_t>() == 3);
+    CHECK(TapeDocument().is_null());
+}
+
+template <typename F>
+double time_ms(F f) {
+    auto start = clk::now();
+    f();
+    return std::chrono::duration<double, std::milli>(clk::now() - start).count();
+}
+//lookups in wide containers: element tables keep them close to JSON (was O(n) per lookup)
+void test_lookup_time() {
+    std::string obj = "{", arr = "[";
+    for (int i = 0; i < 10000; i++) {
+        obj += (i ? ",\"key" : "\"key") + std::to_string(i) + "\":" + std::to_string(i);
+        arr += (i ? "," : "") + std::to_string(i);
+    }
+    obj += '}';
+    arr += ']';
+    TapeDocument to = TapeDocument::from_string(obj), ta = TapeDocument::from_string(arr);
+    JSON jo = JSON::from_string(obj), ja = JSON::from_string(arr);
+    int64_t sum[4] = {};
+    double ms[4] = {
+        time_ms([&] { for (int r = 0; r < 10; r++) for (int i = 0; i < 10000; i++) sum[0] += to["key" + std::to_string(i)].get<int64_t>(); }),
+        time_ms([&] { for (int r = 0; r < 10; r++) for (int i = 0; i < 10000; i++) sum[1] += jo["key" + std::to_string(i)].get<int64_t>(); }),
+        time_ms([&] { for (int r = 0; r < 100; r++) for (size_t i = 0; i < 10000; i++) sum[2] += ta[i].get<int64_t>(); }),
+        time_ms([&] { for (int r = 0; r < 100; r++) for (size_t i = 0; i < 10000; i++) sum[3] += ja[i].get<int64_t>(); }),
+    };
+    CHECK(sum[0] == sum[1] && sum[2] == sum[3]);
+    std::cout << "100k key lookups: tape " << ms[0] << " ms, JSON " << ms[1] << " ms\n";
+    std::cout << "1M index lookups: tape " << ms[2] << " ms, JSON " << ms[3] << " ms\n";
+    CHECK(ms[0] < 4 * ms[1] + 20 && ms[2] < 4 * ms[3] + 20);
+}
+
+int main() {
+    test_random();
+    test_move();
+    test_lookup_time();
+    std::cout << (failures ? "FAILED\n" : "ok\n");
+    return failures ? 1 : 0;
+}